@@ -3,26 +3,77 @@
 // domain. The author hereby disclaims copyright to this source code.
 
 /*
- * NOTE: This is MurmurHash3_x86_32() cleaned up for C99.  The original is at
+ * NOTE: This is MurmurHash3_x86_32() & MurmurHash3_x64_128() cleaned up for
+ * C99.  The original is at
  * https://github.com/aappleby/smhasher/blob/master/src/MurmurHash3.cpp
+ *
+ * The murmurHash3_32x4() & murmurHash3_32x8() functions hash several keys at
+ * once using SSE4.1 or AVX2 when available.  Each result is identical to
+ * murmurHash3_32() of the same key.  With GCC or Clang on x86 the SIMD code
+ * is always compiled and selected at run time if the CPU supports it; other
+ * compilers need the instruction set enabled (e.g. -msse4.1 -mavx2).
+ *
+ * The murmurHash3_init/update/final() functions compute murmurHash3_32()
+ * over data supplied in pieces.
  */
 
 #include <stdint.h>
+#include <string.h>
+#include "murmurHash3.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define TARGET_SSE41    __attribute__((target("sse4.1")))
+#define TARGET_AVX2     __attribute__((target("avx2")))
+#define cpuHasSSE41()   __builtin_cpu_supports("sse4.1")
+#define cpuHasAVX2()    __builtin_cpu_supports("avx2")
+#else
+#define TARGET_SSE41
+#define TARGET_AVX2
+#ifdef __SSE4_1__
+#define cpuHasSSE41()   1
+#endif
+#ifdef __AVX2__
+#define cpuHasAVX2()    1
+#endif
+#endif
+
+#if defined(cpuHasSSE41) || defined(cpuHasAVX2)
+#include <immintrin.h>
+#endif
 
 //-----------------------------------------------------------------------------
 // Platform-specific functions and macros
 
 #define ROTL32(x,r) ((x << r) | (x >> (32 - r)))
+#define ROTL64(x,r) ((x << r) | (x >> (64 - r)))
 
 //-----------------------------------------------------------------------------
 // Block read - if your platform needs to do endian-swapping or can only
 // handle aligned reads, do the conversion here
 
-#ifdef UNALIGNED_U32
-#define getblock32(ptrU32, i)   ptrU32[i]
+#if defined(UNALIGNED_U32)
+#define getblock32(bp)  *((const uint32_t*) (bp))
+#define getblock64(bp)  *((const uint64_t*) (bp))
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+// The compiler turns these into single (unaligned) loads.
+static inline uint32_t getblock32(const uint8_t* bp)
+{
+  uint32_t n;
+  memcpy(&n, bp, 4);
+  return n;
+}
+
+static inline uint64_t getblock64(const uint8_t* bp)
+{
+  uint64_t n;
+  memcpy(&n, bp, 8);
+  return n;
+}
 #else
 // This version works on all CPUs.
-#define getblock32(bp, i)   (((uint32_t)bp[0])|bp[1]<<8|bp[2]<<16|bp[3]<<24)
+#define getblock32(bp) \
+  (((uint32_t)bp[0])|bp[1]<<8|bp[2]<<16|(uint32_t)bp[3]<<24)
+#define getblock64(bp)  (((uint64_t)getblock32((bp+4)))<<32 | getblock32(bp))
 #endif
 
 //-----------------------------------------------------------------------------
@@ -35,15 +86,28 @@
   h *= 0xc2b2ae35; \
   h ^= h >> 16
 
+#define fmix64(k) \
+  k ^= k >> 33; \
+  k *= 0xff51afd7ed558ccdULL; \
+  k ^= k >> 33; \
+  k *= 0xc4ceb9fe1a85ec53ULL; \
+  k ^= k >> 33
+
 //-----------------------------------------------------------------------------
 
-uint32_t murmurHash3_32( const uint8_t* data, int len, uint32_t seed )
+#define C1_32   0xcc9e2d51
+#define C2_32   0x1b873593
+
+/*
+ * Continue a 32-bit hash from block number 'done' to the end of the data.
+ */
+static uint32_t murmur32_resume( const uint8_t* data, int len, int done,
+                                 uint32_t h1 )
 {
-  const uint32_t c1 = 0xcc9e2d51;
-  const uint32_t c2 = 0x1b873593;
+  const uint32_t c1 = C1_32;
+  const uint32_t c2 = C2_32;
   int nblocks = len / 4;
   int i;
-  uint32_t h1 = seed;
   uint32_t k1;
 
 
@@ -51,18 +115,12 @@ uint32_t murmurHash3_32( const uint8_t* data, int len, uint32_t seed )
   // body
 
   const uint8_t* tail = data + nblocks*4;
-#ifdef UNALIGNED_U32
-  const uint32_t * blocks = (const uint32_t *) tail;
-#else
-  const uint8_t* blocks = data;
-#endif
+  const uint8_t* blocks = data + done*4;
 
-  for(i = -nblocks; i; i++)
+  for(i = done; i < nblocks; i++)
   {
-    k1 = getblock32(blocks,i);
-#ifndef UNALIGNED_U32
+    k1 = getblock32(blocks);
     blocks += 4;
-#endif
 
     k1 *= c1;
     k1 = ROTL32(k1,15);
@@ -97,3 +155,362 @@ uint32_t murmurHash3_32( const uint8_t* data, int len, uint32_t seed )
 
   return h1;
 }
+
+uint32_t murmurHash3_32( const uint8_t* data, int len, uint32_t seed )
+{
+  return murmur32_resume( data, len, 0, seed );
+}
+
+//-----------------------------------------------------------------------------
+// Incremental hashing.  The result of init, any number of update calls, and
+// final is the same as murmurHash3_32() of all the data at once.
+
+#define MIX32(h1,k1) \
+  k1 *= C1_32; \
+  k1 = ROTL32(k1,15); \
+  k1 *= C2_32; \
+  h1 ^= k1; \
+  h1 = ROTL32(h1,13); \
+  h1 = h1*5+0xe6546b64
+
+void murmurHash3_init( MurmurHash3State* st, uint32_t seed )
+{
+  st->h1 = seed;
+  st->len = 0;
+  st->tailLen = 0;
+}
+
+void murmurHash3_update( MurmurHash3State* st, const uint8_t* data,
+                         size_t len )
+{
+  const uint8_t* end = data + len;
+  uint32_t h1 = st->h1;
+  uint32_t k1;
+
+  st->len += (uint32_t) len;
+
+  // Complete any partial block from the previous update.
+  if( st->tailLen )
+  {
+    while( st->tailLen < 4 && data != end )
+      st->tail[ st->tailLen++ ] = *data++;
+    if( st->tailLen < 4 )
+      return;
+    k1 = getblock32(st->tail);
+    MIX32(h1,k1);
+    st->tailLen = 0;
+  }
+
+  for( ; end - data >= 4; data += 4 )
+  {
+    k1 = getblock32(data);
+    MIX32(h1,k1);
+  }
+
+  while( data != end )
+    st->tail[ st->tailLen++ ] = *data++;
+  st->h1 = h1;
+}
+
+uint32_t murmurHash3_final( const MurmurHash3State* st )
+{
+  uint32_t h1 = st->h1;
+  uint32_t k1 = 0;
+
+  switch( st->tailLen )
+  {
+  case 3: k1 ^= st->tail[2] << 16;
+    // Fall through...
+  case 2: k1 ^= st->tail[1] << 8;
+    // Fall through...
+  case 1: k1 ^= st->tail[0];
+          k1 *= C1_32; k1 = ROTL32(k1,15); k1 *= C2_32; h1 ^= k1;
+  };
+
+  h1 ^= st->len;
+
+  fmix32(h1);
+
+  return h1;
+}
+
+//-----------------------------------------------------------------------------
+
+/*
+ * Compute the x64 128-bit hash.
+ *
+ * \param out   Two 64-bit values are written here.
+ */
+void murmurHash3_128( const uint8_t* data, int len, uint32_t seed,
+                      uint64_t* out )
+{
+  const uint64_t c1 = 0x87c37b91114253d5ULL;
+  const uint64_t c2 = 0x4cf5ad432745937fULL;
+  int nblocks = len / 16;
+  int i;
+  uint64_t h1 = seed;
+  uint64_t h2 = seed;
+  uint64_t k1, k2;
+
+
+  //----------
+  // body
+
+  const uint8_t* tail = data + nblocks*16;
+  const uint8_t* blocks = data;
+
+  for(i = 0; i < nblocks; i++)
+  {
+    k1 = getblock64(blocks);
+    k2 = getblock64((blocks+8));
+    blocks += 16;
+
+    k1 *= c1; k1 = ROTL64(k1,31); k1 *= c2; h1 ^= k1;
+
+    h1 = ROTL64(h1,27); h1 += h2; h1 = h1*5+0x52dce729;
+
+    k2 *= c2; k2 = ROTL64(k2,33); k2 *= c1; h2 ^= k2;
+
+    h2 = ROTL64(h2,31); h2 += h1; h2 = h2*5+0x38495ab5;
+  }
+
+  //----------
+  // tail
+
+  k1 = 0;
+  k2 = 0;
+
+  switch(len & 15)
+  {
+  case 15: k2 ^= ((uint64_t)tail[14]) << 48;
+    // Fall through...
+  case 14: k2 ^= ((uint64_t)tail[13]) << 40;
+    // Fall through...
+  case 13: k2 ^= ((uint64_t)tail[12]) << 32;
+    // Fall through...
+  case 12: k2 ^= ((uint64_t)tail[11]) << 24;
+    // Fall through...
+  case 11: k2 ^= ((uint64_t)tail[10]) << 16;
+    // Fall through...
+  case 10: k2 ^= ((uint64_t)tail[ 9]) << 8;
+    // Fall through...
+  case  9: k2 ^= ((uint64_t)tail[ 8]);
+           k2 *= c2; k2 = ROTL64(k2,33); k2 *= c1; h2 ^= k2;
+    // Fall through...
+  case  8: k1 ^= ((uint64_t)tail[ 7]) << 56;
+    // Fall through...
+  case  7: k1 ^= ((uint64_t)tail[ 6]) << 48;
+    // Fall through...
+  case  6: k1 ^= ((uint64_t)tail[ 5]) << 40;
+    // Fall through...
+  case  5: k1 ^= ((uint64_t)tail[ 4]) << 32;
+    // Fall through...
+  case  4: k1 ^= ((uint64_t)tail[ 3]) << 24;
+    // Fall through...
+  case  3: k1 ^= ((uint64_t)tail[ 2]) << 16;
+    // Fall through...
+  case  2: k1 ^= ((uint64_t)tail[ 1]) << 8;
+    // Fall through...
+  case  1: k1 ^= ((uint64_t)tail[ 0]);
+           k1 *= c1; k1 = ROTL64(k1,31); k1 *= c2; h1 ^= k1;
+  };
+
+  //----------
+  // finalization
+
+  h1 ^= len;
+  h2 ^= len;
+
+  h1 += h2;
+  h2 += h1;
+
+  fmix64(h1);
+  fmix64(h2);
+
+  h1 += h2;
+  h2 += h1;
+
+  out[0] = h1;
+  out[1] = h2;
+}
+
+//-----------------------------------------------------------------------------
+// Multi-buffer hashing.  The blocks common to all keys are mixed in SIMD
+// lanes, then each lane is finished with murmur32_resume().
+
+#ifdef cpuHasSSE41
+static int murmur32_minBlocks( const int* len, int count )
+{
+  int i;
+  int n = len[0];
+  for( i = 1; i < count; ++i )
+  {
+    if( len[i] < n )
+      n = len[i];
+  }
+  return n / 4;
+}
+
+#define ROTL32_4(x,r) \
+  _mm_or_si128(_mm_slli_epi32(x,r), _mm_srli_epi32(x,32-r))
+
+#define MIX32_4(h,k) \
+  k = _mm_mullo_epi32(k, c1); \
+  k = ROTL32_4(k,15); \
+  k = _mm_mullo_epi32(k, c2); \
+  h = _mm_xor_si128(h, k); \
+  h = ROTL32_4(h,13); \
+  h = _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(h,2), h), c3)
+
+// Transpose four rows of four blocks so that k0-k3 each hold one block
+// from every row.
+#define TRANSPOSE_4(r0,r1,r2,r3,k0,k1,k2,k3) { \
+  __m128i t0 = _mm_unpacklo_epi32(r0, r1); \
+  __m128i t1 = _mm_unpacklo_epi32(r2, r3); \
+  __m128i t2 = _mm_unpackhi_epi32(r0, r1); \
+  __m128i t3 = _mm_unpackhi_epi32(r2, r3); \
+  k0 = _mm_unpacklo_epi64(t0, t1); \
+  k1 = _mm_unpackhi_epi64(t0, t1); \
+  k2 = _mm_unpacklo_epi64(t2, t3); \
+  k3 = _mm_unpackhi_epi64(t2, t3); \
+}
+
+#define LOAD_4(p,off)   _mm_loadu_si128((const __m128i*) (p + off))
+#endif
+
+#ifdef cpuHasSSE41
+TARGET_SSE41
+static void murmur32x4_sse41( const uint8_t* const* data, const int* len,
+                              uint32_t seed, uint32_t* out )
+{
+  const __m128i c1 = _mm_set1_epi32(C1_32);
+  const __m128i c2 = _mm_set1_epi32(C2_32);
+  const __m128i c3 = _mm_set1_epi32(0xe6546b64);
+  __m128i h = _mm_set1_epi32(seed);
+  __m128i k0, k1, k2, k3;
+  uint32_t hv[4];
+  int nblocks = murmur32_minBlocks( len, 4 );
+  int off = 0;
+  int i;
+
+  for(i = 0; i + 4 <= nblocks; i += 4, off += 16)
+  {
+    TRANSPOSE_4(LOAD_4(data[0],off), LOAD_4(data[1],off),
+                LOAD_4(data[2],off), LOAD_4(data[3],off), k0, k1, k2, k3);
+    MIX32_4(h,k0);
+    MIX32_4(h,k1);
+    MIX32_4(h,k2);
+    MIX32_4(h,k3);
+  }
+  for(; i < nblocks; i++, off += 4)
+  {
+    k0 = _mm_set_epi32(getblock32((data[3]+off)), getblock32((data[2]+off)),
+                       getblock32((data[1]+off)), getblock32((data[0]+off)));
+    MIX32_4(h,k0);
+  }
+
+  _mm_storeu_si128((__m128i*) hv, h);
+  for(i = 0; i < 4; ++i)
+    out[i] = murmur32_resume( data[i], len[i], nblocks, hv[i] );
+}
+#endif
+
+/*
+ * Compute murmurHash3_32() of four keys.
+ *
+ * \param data  Array of four key pointers.
+ * \param len   Array of four key lengths.
+ * \param out   Four hash values are written here.
+ */
+void murmurHash3_32x4( const uint8_t* const* data, const int* len,
+                       uint32_t seed, uint32_t* out )
+{
+  int i;
+#ifdef cpuHasSSE41
+  if( cpuHasSSE41() )
+  {
+    murmur32x4_sse41( data, len, seed, out );
+    return;
+  }
+#endif
+  for(i = 0; i < 4; ++i)
+    out[i] = murmur32_resume( data[i], len[i], 0, seed );
+}
+
+#ifdef cpuHasAVX2
+TARGET_AVX2
+static void murmur32x8_avx2( const uint8_t* const* data, const int* len,
+                             uint32_t seed, uint32_t* out )
+{
+  const __m256i c1 = _mm256_set1_epi32(C1_32);
+  const __m256i c2 = _mm256_set1_epi32(C2_32);
+  const __m256i c3 = _mm256_set1_epi32(0xe6546b64);
+  __m256i h = _mm256_set1_epi32(seed);
+  __m256i k;
+  __m128i a0, a1, a2, a3, b0, b1, b2, b3;
+  uint32_t hv[8];
+  int nblocks = murmur32_minBlocks( len, 8 );
+  int off = 0;
+  int i;
+
+#define ROTL32_8(x,r) \
+  _mm256_or_si256(_mm256_slli_epi32(x,r), _mm256_srli_epi32(x,32-r))
+#define MIX32_8(h,k) \
+  k = _mm256_mullo_epi32(k, c1); \
+  k = ROTL32_8(k,15); \
+  k = _mm256_mullo_epi32(k, c2); \
+  h = _mm256_xor_si256(h, k); \
+  h = ROTL32_8(h,13); \
+  h = _mm256_add_epi32(_mm256_add_epi32(_mm256_slli_epi32(h,2), h), c3)
+
+  for(i = 0; i + 4 <= nblocks; i += 4, off += 16)
+  {
+    TRANSPOSE_4(LOAD_4(data[0],off), LOAD_4(data[1],off),
+                LOAD_4(data[2],off), LOAD_4(data[3],off), a0, a1, a2, a3);
+    TRANSPOSE_4(LOAD_4(data[4],off), LOAD_4(data[5],off),
+                LOAD_4(data[6],off), LOAD_4(data[7],off), b0, b1, b2, b3);
+    k = _mm256_set_m128i(b0, a0);
+    MIX32_8(h,k);
+    k = _mm256_set_m128i(b1, a1);
+    MIX32_8(h,k);
+    k = _mm256_set_m128i(b2, a2);
+    MIX32_8(h,k);
+    k = _mm256_set_m128i(b3, a3);
+    MIX32_8(h,k);
+  }
+  for(; i < nblocks; i++, off += 4)
+  {
+    k = _mm256_set_epi32(
+          getblock32((data[7]+off)), getblock32((data[6]+off)),
+          getblock32((data[5]+off)), getblock32((data[4]+off)),
+          getblock32((data[3]+off)), getblock32((data[2]+off)),
+          getblock32((data[1]+off)), getblock32((data[0]+off)));
+    MIX32_8(h,k);
+  }
+
+  _mm256_storeu_si256((__m256i*) hv, h);
+  for(i = 0; i < 8; ++i)
+    out[i] = murmur32_resume( data[i], len[i], nblocks, hv[i] );
+}
+#endif
+
+/*
+ * Compute murmurHash3_32() of eight keys.
+ *
+ * \param data  Array of eight key pointers.
+ * \param len   Array of eight key lengths.
+ * \param out   Eight hash values are written here.
+ */
+void murmurHash3_32x8( const uint8_t* const* data, const int* len,
+                       uint32_t seed, uint32_t* out )
+{
+#ifdef cpuHasAVX2
+  if( cpuHasAVX2() )
+  {
+    murmur32x8_avx2( data, len, seed, out );
+    return;
+  }
+#endif
+  murmurHash3_32x4( data, len, seed, out );
+  murmurHash3_32x4( data + 4, len + 4, seed, out + 4 );
+}
@@ -0,0 +1,38 @@
+#ifndef MURMURHASH3_H
+#define MURMURHASH3_H
+/*
+ * MurmurHash3 was written by Austin Appleby, and is placed in the public
+ * domain. The author hereby disclaims copyright to this source code.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+// State for hashing data incrementally with murmurHash3_update().
+typedef struct {
+    uint32_t h1;
+    uint32_t len;       // Total length (modulo 2^32).
+    uint8_t  tail[4];   // Partial block.
+    uint32_t tailLen;
+} MurmurHash3State;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t murmurHash3_32(const uint8_t* data, int len, uint32_t seed);
+void murmurHash3_128(const uint8_t* data, int len, uint32_t seed,
+                     uint64_t* out);
+void murmurHash3_32x4(const uint8_t* const* data, const int* len,
+                      uint32_t seed, uint32_t* out);
+void murmurHash3_32x8(const uint8_t* const* data, const int* len,
+                      uint32_t seed, uint32_t* out);
+void murmurHash3_init(MurmurHash3State*, uint32_t seed);
+void murmurHash3_update(MurmurHash3State*, const uint8_t* data, size_t len);
+uint32_t murmurHash3_final(const MurmurHash3State*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // MURMURHASH3_H
@@ -24,12 +24,20 @@
 
 
 //#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "quickSortIndex.h"
 
+#if defined(QUICKSORT_THREADS) && ! defined(_WIN32)
+#include <pthread.h>
+#endif
+
 
 //#define DEBUG_SORT  1
 
 #define INSERT_SIZE 10
+#define NINTHER_SIZE    128
+#define PARALLEL_SIZE   8192
 #define isGT(a,b)   (qs->compare(qs->user, a, b) > 0)
 #define isLT(a,b)   (qs->compare(qs->user, a, b) < 0)
 #define VALUE(n)    (data + (index[n] * qs->elemSize))
@@ -40,7 +48,144 @@
     index[b] = tmp
 
 
-static void qsortIndex( const QuickSortIndex* qs, uint32_t l, uint32_t r )
+/*
+  Return the position (a, b, or c) holding the median value.
+*/
+static uint32_t median3( const QuickSortIndex* qs, uint32_t a, uint32_t b,
+                         uint32_t c )
+{
+    uint8_t* data = qs->data;
+    uint32_t* index = qs->index;
+
+    if( isLT( VALUE(a), VALUE(b) ) )
+    {
+        if( isLT( VALUE(b), VALUE(c) ) )
+            return b;
+        return isLT( VALUE(a), VALUE(c) ) ? c : a;
+    }
+    if( isLT( VALUE(a), VALUE(c) ) )
+        return a;
+    return isLT( VALUE(b), VALUE(c) ) ? c : b;
+}
+
+
+/*
+  Heap sort index[l..r].  Used when partitioning goes too deep.
+*/
+static void heapSortIndex( const QuickSortIndex* qs, uint32_t l, uint32_t r )
+{
+    uint8_t* data = qs->data;
+    uint32_t* index = qs->index + l;
+    uint32_t n = r - l + 1;
+    uint32_t i, root, child;
+    uint32_t tmp;
+
+    // Build max-heap then repeatedly move the maximum to the end.
+    i = n / 2;
+    while( 1 )
+    {
+        if( i > 0 )
+            root = --i;
+        else
+        {
+            if( --n == 0 )
+                break;
+            swap( 0, n );
+            root = 0;
+        }
+
+        // Sift down.
+        while( (child = root * 2 + 1) < n )
+        {
+            if( child + 1 < n && isLT( VALUE(child), VALUE(child + 1) ) )
+                ++child;
+            if( ! isLT( VALUE(root), VALUE(child) ) )
+                break;
+            swap( root, child );
+            root = child;
+        }
+    }
+}
+
+
+/*
+  Partition index[l..r] around a pivot and return the final pivot position.
+*/
+static uint32_t partitionIndex( const QuickSortIndex* qs, uint32_t l,
+                                uint32_t r )
+{
+    uint8_t* pivot;
+    uint8_t* data = qs->data;
+    uint32_t* index = qs->index;
+    uint32_t i, j;
+    uint32_t p;
+    uint32_t tmp;
+
+    p = (l + r) / 2;
+    if( r - l >= NINTHER_SIZE )
+    {
+        // On large ranges the middle is first replaced with the median of
+        // three medians-of-three (Tukey's ninther).
+        uint32_t s = (r - l) / 8;
+        i = median3( qs, median3( qs, l + 1, l + s, l + s * 2 ),
+                         median3( qs, p - s, p, p + s ),
+                         median3( qs, r - s * 2, r - s, r - 1 ) );
+        swap( i, p );
+    }
+
+    // Select pivot using median-of-three.
+#ifdef DEBUG_SORT
+    printf( "median %d %d %d\n", l, p, r );
+#endif
+    if( isGT( VALUE(l), VALUE(p) ) )
+    {
+        swap( l, p );
+    }
+    if( isGT( VALUE(l), VALUE(r) ) )
+    {
+        swap( l, r );
+    }
+    if( isGT( VALUE(p), VALUE(r) ) )
+    {
+        swap( p, r );
+    }
+
+    // Move pivot to end.
+    swap( p, r );
+    pivot = VALUE(r);
+
+    i = l;
+    j = r - 1;
+    while( 1 )
+    {
+        while( i < j && isLT( VALUE(i), pivot ) )
+            ++i;
+        while( i < j && isGT( VALUE(j), pivot ) )
+            --j;
+        if( i >= j )
+            break;
+        // Elements equal to the pivot are swapped too so that runs of
+        // duplicates are split evenly.
+        swap( i, j );
+        ++i;
+        --j;
+    }
+
+    // Restore pivot.  If the scans met then index[i] is still unchecked.
+    if( i == j && ! isGT( VALUE(i), pivot ) )
+        ++i;
+    swap( i, r );
+    return i;
+}
+
+
+/*
+  Introspective sort of index[l..r].  Only the smaller partition is sorted
+  recursively so the stack depth is limited to log2(n).  If the partitioning
+  goes more than depth levels deep then heap sort is used.
+*/
+static void qsortIndex( const QuickSortIndex* qs, uint32_t l, uint32_t r,
+                        int depth )
 {
     uint8_t* pivot;
     uint8_t* data = qs->data;
@@ -56,74 +201,150 @@ static void qsortIndex( const QuickSortIndex* qs, uint32_t l, uint32_t r )
     printf( "]\n" );
 #endif
 
-    if( (l + INSERT_SIZE) > r )
-    {
-#ifdef DEBUG_SORT
-        printf( "insertion\n" );
-#endif
-        // Insertion sorting on small series.
-        for( p = l + 1; p <= r; p++ )
-        {
-            tmp = index[p];
-            pivot = data + (tmp * qs->elemSize);
-            for( j = p; j > l; j-- )
-            {
-                if( isGT( pivot, VALUE(j - 1) ) )
-                    break;
-                index[j] = index[j - 1];
-            }
-            index[j] = tmp;
-        }
-    }
-    else
+    while( (l + INSERT_SIZE) <= r )
     {
-        // Select pivot using median-of-three.
-        p = (l + r) / 2;
-#ifdef DEBUG_SORT
-        printf( "median %d %d %d\n", l, p, r );
-#endif
-        if( isGT( VALUE(l), VALUE(p) ) )
+        if( depth-- == 0 )
         {
-            swap( l, p );
+            heapSortIndex( qs, l, r );
+            return;
         }
-        if( isGT( VALUE(l), VALUE(r) ) )
+
+        i = partitionIndex( qs, l, r );
+        if( i - l < r - i )
         {
-            swap( l, r );
+            if( l < i )
+                qsortIndex( qs, l, i - 1, depth );
+            l = i + 1;
         }
-        if( isGT( VALUE(p), VALUE(r) ) )
+        else
         {
-            swap( p, r );
+            if( r > i )
+                qsortIndex( qs, i + 1, r, depth );
+            if( i == l )
+                return;
+            r = i - 1;
         }
+    }
 
-        // Move pivot to end.
-        swap( p, r );
-        pivot = VALUE(r);
-
-        i = l;
-        j = r - 1;
-        while( 1 )
+#ifdef DEBUG_SORT
+    printf( "insertion\n" );
+#endif
+    // Insertion sorting on small series.
+    for( p = l + 1; p <= r; p++ )
+    {
+        tmp = index[p];
+        pivot = data + (tmp * qs->elemSize);
+        for( j = p; j > l; j-- )
         {
-            while( i < j && isLT( VALUE(i), pivot ) )
-                ++i;
-            while( i < j && isGT( VALUE(j), pivot ) )
-                --j;
-            if( i >= j )
+            if( isGT( pivot, VALUE(j - 1) ) )
                 break;
-            swap( i, j );
-            ++i;
+            index[j] = index[j - 1];
         }
+        index[j] = tmp;
+    }
+}
 
-        // Restore pivot.
-        if( isGT( VALUE(i), pivot ) )
-        {
-            swap( i, r );
-        }
 
-        if( l < i )
-            qsortIndex( qs, l, i - 1 );
-        if( r > i )
-            qsortIndex( qs, i + 1, r );
+static int depthLimit( uint32_t n )
+{
+    int depth = 0;
+    while( n >>= 1 )
+        ++depth;
+    return depth * 2;
+}
+
+
+#if defined(QUICKSORT_THREADS) && ! defined(_WIN32)
+typedef struct
+{
+    const QuickSortIndex* qs;
+    uint32_t l, r;
+    int depth;
+    int threads;
+}
+QSortTask;
+
+static void qsortIndexMT( const QSortTask* );
+
+static void* qsortTaskThread( void* arg )
+{
+    qsortIndexMT( (const QSortTask*) arg );
+    return NULL;
+}
+
+/*
+  Partition and hand the left part to a new thread until each thread has
+  a part to sort.
+*/
+static void qsortIndexMT( const QSortTask* task )
+{
+    const QuickSortIndex* qs = task->qs;
+    QSortTask left, right;
+    pthread_t thr;
+    uint32_t i;
+
+    if( task->threads < 2 || task->r - task->l < PARALLEL_SIZE ||
+        task->depth == 0 )
+    {
+        qsortIndex( qs, task->l, task->r, task->depth );
+        return;
+    }
+
+    i = partitionIndex( qs, task->l, task->r );
+
+    left.qs = right.qs = qs;
+    left.depth = right.depth = task->depth - 1;
+    left.threads  = task->threads / 2;
+    right.threads = task->threads - left.threads;
+    left.l  = task->l;
+    left.r  = i - 1;
+    right.l = i + 1;
+    right.r = task->r;
+
+    if( i - task->l < PARALLEL_SIZE || task->r - i < PARALLEL_SIZE )
+    {
+        // A lopsided partition is not worth a thread.  The small side is
+        // sorted here and the large side gets all the threads.
+        left.threads = right.threads = task->threads;
+        if( i > task->l )
+            qsortIndexMT( &left );
+        if( i < task->r )
+            qsortIndexMT( &right );
+    }
+    else if( pthread_create( &thr, NULL, qsortTaskThread, &left ) == 0 )
+    {
+        qsortIndexMT( &right );
+        pthread_join( thr, NULL );
+    }
+    else
+    {
+        qsortIndexMT( &left );
+        qsortIndexMT( &right );
+    }
+}
+#endif
+
+
+static uint32_t fillIndex( const QuickSortIndex* qs, uint32_t begin,
+                           uint32_t end, uint32_t stride )
+{
+    uint32_t icount;
+    uint32_t* ip = qs->index;
+
+    icount = (end - begin) / stride;
+    if( icount < 2 )
+    {
+        if( icount == 1 )
+            *ip = begin;
+        else
+            icount = 0;
+    }
+    else
+    {
+        for( ; begin < end; begin += stride )
+            *ip++ = begin;
     }
+    return icount;
 }
 
 
@@ -147,22 +368,258 @@ static void qsortIndex( const QuickSortIndex* qs, uint32_t l, uint32_t r )
 int quickSortIndex( const QuickSortIndex* qs, uint32_t begin, uint32_t end,
                     uint32_t stride )
 {
-    uint32_t icount;
-    uint32_t* ip = qs->index;
+    uint32_t icount = fillIndex( qs, begin, end, stride );
+    if( icount > 1 )
+        qsortIndex( qs, 0, icount - 1, depthLimit( icount ) );
+    return icount;
+}
 
-    icount = (end - begin) / stride;
-    if( icount < 2 )
+
+/*
+  Same as quickSortIndex() but the sort is split across a number of threads.
+
+  Threads are only used if the module is compiled with QUICKSORT_THREADS
+  defined (pthreads is required).  The compare callback must be safe to call
+  from multiple threads.
+
+  \param threads  Maximum number of threads to use.
+
+  \return  Number of indicies set and sorted in qs->index.
+*/
+int quickSortIndexMT( const QuickSortIndex* qs, uint32_t begin, uint32_t end,
+                      uint32_t stride, int threads )
+{
+    uint32_t icount = fillIndex( qs, begin, end, stride );
+    if( icount > 1 )
     {
-        if( icount == 1 )
-            *ip = begin;
+#if defined(QUICKSORT_THREADS) && ! defined(_WIN32)
+        QSortTask task;
+        task.qs = qs;
+        task.l = 0;
+        task.r = icount - 1;
+        task.depth = depthLimit( icount );
+        task.threads = threads;
+        qsortIndexMT( &task );
+#else
+        (void) threads;
+        qsortIndex( qs, 0, icount - 1, depthLimit( icount ) );
+#endif
+    }
+    return icount;
+}
+
+
+/*
+  Partition index[l..r] until index[nth] holds the element which would be
+  there if the range were sorted.
+*/
+static void selectIndex( const QuickSortIndex* qs, uint32_t l, uint32_t r,
+                         uint32_t nth, int depth )
+{
+    uint32_t i;
+
+    while( (l + INSERT_SIZE) <= r )
+    {
+        if( depth-- == 0 )
+        {
+            heapSortIndex( qs, l, r );
+            return;
+        }
+
+        i = partitionIndex( qs, l, r );
+        if( nth == i )
+            return;
+        if( nth < i )
+            r = i - 1;
         else
-            icount = 0;
+            l = i + 1;
+    }
+    qsortIndex( qs, l, r, 0 );
+}
+
+
+/*
+  Fill the index and partially order it so that qs->index[nth] is the
+  element which would be there if the index were fully sorted.  All
+  elements before it are less than or equal to it and all elements after
+  are greater than or equal to it.
+
+  This does O(n) work on average rather than the O(n log n) of a full sort.
+
+  \param begin   First index.
+  \param end     Ending index (not included in the sort).
+  \param stride  Index increment.
+  \param nth     Position in the index to select.
+
+  \return  Number of indicies set in qs->index.
+*/
+int nthElementIndex( const QuickSortIndex* qs, uint32_t begin, uint32_t end,
+                     uint32_t stride, uint32_t nth )
+{
+    uint32_t icount = fillIndex( qs, begin, end, stride );
+    if( nth < icount )
+        selectIndex( qs, 0, icount - 1, nth, depthLimit( icount ) );
+    return icount;
+}
+
+
+/*
+  Fill the index and sort only the first k entries.  The order of the
+  remaining entries is unspecified.
+
+  \param begin   First index.
+  \param end     Ending index (not included in the sort).
+  \param stride  Index increment.
+  \param k       Number of leading entries to sort.
+
+  \return  Number of indicies set in qs->index.
+*/
+int partialSortIndex( const QuickSortIndex* qs, uint32_t begin, uint32_t end,
+                      uint32_t stride, uint32_t k )
+{
+    uint32_t icount = fillIndex( qs, begin, end, stride );
+    if( k > icount )
+        k = icount;
+    if( k > 0 )
+    {
+        selectIndex( qs, 0, icount - 1, k - 1, depthLimit( icount ) );
+        if( k > 1 )
+            qsortIndex( qs, 0, k - 2, depthLimit( k ) );
+    }
+    return icount;
+}
+
+
+/*
+  LSD radix sort of (key, index) pairs by 8-bit digits.  The pairs are
+  moved between the two buffers on each pass and a pointer to the buffer
+  holding the final index order is returned.  Passes where every key has
+  the same digit are skipped.
+*/
+#define RADIX_IMP(NAME, KT) \
+static uint32_t* NAME( KT* key, uint32_t* idx, KT* key2, uint32_t* idx2, \
+                       uint32_t n ) \
+{ \
+    uint32_t count[sizeof(KT)][256]; \
+    uint32_t* cp; \
+    uint32_t* ts; \
+    KT* tk; \
+    uint32_t i, sum, c; \
+    int pass, shift; \
+\
+    memset( count, 0, sizeof(count) ); \
+    for( i = 0; i < n; ++i ) \
+    { \
+        KT k = key[i]; \
+        for( pass = 0; pass < (int) sizeof(KT); ++pass ) \
+            ++count[pass][ (k >> (pass * 8)) & 255 ]; \
+    } \
+\
+    for( pass = 0; pass < (int) sizeof(KT); ++pass ) \
+    { \
+        cp = count[pass]; \
+        shift = pass * 8; \
+        if( cp[ (key[0] >> shift) & 255 ] == n ) \
+            continue; \
+        for( sum = i = 0; i < 256; ++i ) \
+        { \
+            c = cp[i]; \
+            cp[i] = sum; \
+            sum += c; \
+        } \
+        for( i = 0; i < n; ++i ) \
+        { \
+            c = cp[ (key[i] >> shift) & 255 ]++; \
+            key2[c] = key[i]; \
+            idx2[c] = idx[i]; \
+        } \
+        tk = key;  key = key2;  key2 = tk; \
+        ts = idx;  idx = idx2;  idx2 = ts; \
+    } \
+    return idx; \
+}
+
+RADIX_IMP( radixSort32, uint32_t )
+RADIX_IMP( radixSort64, uint64_t )
+
+
+/*
+  Sort an index of elements by a numeric key stored in each element.
+
+  This is a stable LSD radix sort which does not use qs->compare.  Only the
+  index, data, and elemSize members of the QuickSortIndex are used.  The
+  index is filled the same way as quickSortIndex().
+
+  For n = (end - begin) / stride indices, temporary memory of 12 * n bytes
+  is allocated for 32-bit keys or 20 * n bytes for 64-bit keys.
+
+  \param begin      First index.
+  \param end        Ending index (not included in the sort).
+  \param stride     Index increment.
+  \param keyOffset  Byte offset of key in each element.
+  \param keyType    QSORT_KEY_U32, QSORT_KEY_I32, QSORT_KEY_U64, or
+                    QSORT_KEY_FLOAT.
+
+  \return  Number of indicies set and sorted in qs->index or -1 if memory
+           could not be allocated.
+*/
+int radixSortIndex( const QuickSortIndex* qs, uint32_t begin, uint32_t end,
+                    uint32_t stride, uint32_t keyOffset, int keyType )
+{
+    const uint8_t* data = qs->data + keyOffset;
+    uint32_t* index = qs->index;
+    uint32_t* idx2;
+    uint32_t* res;
+    void* mem;
+    uint32_t icount, i;
+    uint32_t k;
+
+    icount = fillIndex( qs, begin, end, stride );
+    if( icount < 2 )
+        return icount;
+
+    if( keyType == QSORT_KEY_U64 )
+    {
+        uint64_t* key;
+        uint64_t k64;
+
+        mem = malloc( icount * (2 * sizeof(uint64_t) + sizeof(uint32_t)) );
+        if( ! mem )
+            return -1;
+        key = (uint64_t*) mem;
+        idx2 = (uint32_t*) (key + icount * 2);
+        for( i = 0; i < icount; ++i )
+        {
+            memcpy( &k64, VALUE(i), sizeof(uint64_t) );
+            key[i] = k64;
+        }
+        res = radixSort64( key, index, key + icount, idx2, icount );
     }
     else
     {
-        for( ; begin < end; begin += stride )
-            *ip++ = begin;
-        qsortIndex( qs, 0, icount - 1 );
+        uint32_t* key;
+
+        mem = malloc( icount * 3 * sizeof(uint32_t) );
+        if( ! mem )
+            return -1;
+        key = (uint32_t*) mem;
+        idx2 = key + icount * 2;
+        for( i = 0; i < icount; ++i )
+        {
+            // Map signed & float keys to unsigned integers with the
+            // same ordering.
+            memcpy( &k, VALUE(i), sizeof(uint32_t) );
+            if( keyType == QSORT_KEY_I32 )
+                k ^= 0x80000000;
+            else if( keyType == QSORT_KEY_FLOAT )
+                k ^= (k & 0x80000000) ? 0xffffffff : 0x80000000;
+            key[i] = k;
+        }
+        res = radixSort32( key, index, key + icount, idx2, icount );
     }
+
+    if( res != index )
+        memcpy( index, res, icount * sizeof(uint32_t) );
+    free( mem );
     return icount;
 }
@@ -12,6 +12,14 @@
 #include <stdint.h>
 
 
+enum QuickSortKeyType
+{
+    QSORT_KEY_U32,
+    QSORT_KEY_I32,
+    QSORT_KEY_U64,
+    QSORT_KEY_FLOAT
+};
+
 typedef struct QuickSortIndex   QuickSortIndex;
 typedef int (*QuickSortFunc)( void* user, void* a, void* b );
 
@@ -27,6 +35,136 @@ struct QuickSortIndex
 
 extern int quickSortIndex( const QuickSortIndex*,
                            uint32_t first, uint32_t last, uint32_t stride );
+extern int quickSortIndexMT( const QuickSortIndex*,
+                             uint32_t first, uint32_t last, uint32_t stride,
+                             int threads );
+extern int nthElementIndex( const QuickSortIndex*,
+                            uint32_t first, uint32_t last, uint32_t stride,
+                            uint32_t nth );
+extern int partialSortIndex( const QuickSortIndex*,
+                             uint32_t first, uint32_t last, uint32_t stride,
+                             uint32_t k );
+extern int radixSortIndex( const QuickSortIndex*,
+                           uint32_t first, uint32_t last, uint32_t stride,
+                           uint32_t keyOffset, int keyType );
+
+
+/*
+  Index Sort Template
+
+  QSORT_INDEX_IMP generates a quickSortIndex() for a single element type
+  with the comparison inlined.  LESS(a,b) is a macro or inline function
+  which is passed two (const ET*) and returns non-zero if a sorts before b.
+
+  Example Usage:
+
+    #define rec_less(a,b)  ((a)->key < (b)->key)
+    QSORT_INDEX_IMP(rec, Record, rec_less)
+
+    count = rec_sortIndex(index, records, 0, recordCount, 1);
+
+  int PRE_sortIndex(uint32_t* index, const ET* data,
+                    uint32_t begin, uint32_t end, uint32_t stride)
+  Fill index and sort it.  Returns the number of indices set.
+*/
+
+#define QSORT_INDEX_INSERT  10
+
+#define QSORT_INDEX_IMP(PRE, ET, LESS) \
+static void PRE ## _heapSortIndex(uint32_t* index, const ET* data, \
+                                  uint32_t n) { \
+    uint32_t i = n / 2, root, child, tmp; \
+    for (;;) { \
+        if (i > 0) \
+            root = --i; \
+        else { \
+            if (--n == 0) \
+                break; \
+            tmp = index[0]; index[0] = index[n]; index[n] = tmp; \
+            root = 0; \
+        } \
+        while ((child = root * 2 + 1) < n) { \
+            if (child + 1 < n && \
+                LESS(data + index[child], data + index[child + 1])) \
+                ++child; \
+            if (! LESS(data + index[root], data + index[child])) \
+                break; \
+            tmp = index[root]; index[root] = index[child]; \
+            index[child] = tmp; \
+            root = child; \
+        } \
+    } \
+} \
+static void PRE ## _sortIndexR(uint32_t* index, const ET* data, \
+                               uint32_t l, uint32_t r, int depth) { \
+    const ET* pivot; \
+    uint32_t i, j, p, tmp; \
+    while (l + QSORT_INDEX_INSERT <= r) { \
+        if (depth-- == 0) { \
+            PRE ## _heapSortIndex(index + l, data, r - l + 1); \
+            return; \
+        } \
+        /* Median-of-three pivot moved to r. */ \
+        p = (l + r) / 2; \
+        if (LESS(data + index[p], data + index[l])) { \
+            tmp = index[l]; index[l] = index[p]; index[p] = tmp; \
+        } \
+        if (LESS(data + index[r], data + index[l])) { \
+            tmp = index[l]; index[l] = index[r]; index[r] = tmp; \
+        } \
+        if (LESS(data + index[p], data + index[r])) { \
+            tmp = index[p]; index[p] = index[r]; index[r] = tmp; \
+        } \
+        pivot = data + index[r]; \
+        i = l; \
+        j = r - 1; \
+        for (;;) { \
+            while (i < j && LESS(data + index[i], pivot)) \
+                ++i; \
+            while (i < j && LESS(pivot, data + index[j])) \
+                --j; \
+            if (i >= j) \
+                break; \
+            tmp = index[i]; index[i] = index[j]; index[j] = tmp; \
+            ++i; \
+            --j; \
+        } \
+        if (i == j && ! LESS(pivot, data + index[i])) \
+            ++i; \
+        tmp = index[i]; index[i] = index[r]; index[r] = tmp; \
+        /* Recurse into the smaller side. */ \
+        if (i - l < r - i) { \
+            if (l < i) \
+                PRE ## _sortIndexR(index, data, l, i - 1, depth); \
+            l = i + 1; \
+        } else { \
+            if (r > i) \
+                PRE ## _sortIndexR(index, data, i + 1, r, depth); \
+            if (i == l) \
+                return; \
+            r = i - 1; \
+        } \
+    } \
+    for (p = l + 1; p <= r; ++p) { \
+        tmp = index[p]; \
+        for (j = p; j > l && LESS(data + tmp, data + index[j - 1]); --j) \
+            index[j] = index[j - 1]; \
+        index[j] = tmp; \
+    } \
+} \
+int PRE ## _sortIndex(uint32_t* index, const ET* data, \
+                      uint32_t begin, uint32_t end, uint32_t stride) { \
+    uint32_t i, n = (end - begin) / stride; \
+    int depth = 0; \
+    for (i = 0; i < n; ++i, begin += stride) \
+        index[i] = begin; \
+    if (n > 1) { \
+        for (i = n; i >>= 1; ) \
+            depth += 2; \
+        PRE ## _sortIndexR(index, data, 0, n - 1, depth); \
+    } \
+    return n; \
+}
 
 
 #endif
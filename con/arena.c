@@ -0,0 +1,234 @@
+/*
+  Arena Allocator
+  Dedicated to the public domain.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#define HUGE_PAGE_SIZE  (2*1024*1024)
+#endif
+
+#define DEFAULT_BLOCK   (64*1024)
+#define ALIGN_UP(n,a)   (((n) + (a) - 1) & ~((size_t) (a) - 1))
+
+struct ArenaBlock {
+    ArenaBlock* prev;
+    size_t size;        // Bytes of memory following the header.
+    int mapped;
+};
+
+// Block memory starts after the header, keeping ARENA_ALIGN alignment.
+#define HEADER_SIZE     ALIGN_UP(sizeof(ArenaBlock), ARENA_ALIGN)
+#define BLOCK_MEM(blk)  (((char*) (blk)) + HEADER_SIZE)
+
+
+/**
+  Initialize arena.  No memory is allocated until the first arena_alloc().
+
+  \param blockSize  Minimum size of each block.  If zero then 64K is used.
+  \param flags      Zero or ARENA_HUGE_PAGES.
+*/
+void arena_init(Arena* ar, size_t blockSize, uint32_t flags)
+{
+    memset(ar, 0, sizeof(Arena));
+    ar->blockSize = blockSize ? blockSize : DEFAULT_BLOCK;
+    ar->flags = flags;
+}
+
+static void arena_releaseBlocks(ArenaBlock* blk)
+{
+    ArenaBlock* prev;
+    while (blk) {
+        prev = blk->prev;
+#ifdef HUGE_PAGE_SIZE
+        if (blk->mapped)
+            munmap(blk, blk->size + HEADER_SIZE);
+        else
+#endif
+            free(blk);
+        blk = prev;
+    }
+}
+
+/**
+  Free all memory used by the arena.
+*/
+void arena_free(Arena* ar)
+{
+    arena_releaseBlocks(ar->block);
+    arena_releaseBlocks(ar->spare);
+    arena_init(ar, ar->blockSize, ar->flags);
+}
+
+/*
+  Allocate block with at least size bytes of memory.
+*/
+static ArenaBlock* arena_newBlock(Arena* ar, size_t size)
+{
+    ArenaBlock* blk;
+    ArenaBlock** link;
+    size_t total;
+
+    // Take the first spare block which is big enough.
+    for (link = &ar->spare; (blk = *link); link = &blk->prev) {
+        if (blk->size >= size) {
+            *link = blk->prev;
+            return blk;
+        }
+    }
+
+    total = size + HEADER_SIZE;
+#ifdef HUGE_PAGE_SIZE
+    if (ar->flags & ARENA_HUGE_PAGES) {
+        void* mem;
+        total = ALIGN_UP(total, HUGE_PAGE_SIZE);
+        mem = mmap(NULL, total, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (mem == MAP_FAILED) {
+            // No reserved huge pages; ask for transparent ones instead.
+            mem = mmap(NULL, total, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mem == MAP_FAILED)
+                return NULL;
+#ifdef MADV_HUGEPAGE
+            madvise(mem, total, MADV_HUGEPAGE);
+#endif
+        }
+        blk = (ArenaBlock*) mem;
+        blk->mapped = 1;
+    } else
+#endif
+    {
+        blk = (ArenaBlock*) malloc(total);
+        if (! blk)
+            return NULL;
+        blk->mapped = 0;
+    }
+    blk->size = total - HEADER_SIZE;
+    ar->blockCount++;
+    return blk;
+}
+
+/**
+  Allocate memory with a specific alignment.
+
+  \param align  Alignment in bytes.  Must be a power of two.
+
+  \return Pointer to memory or NULL if a new block could not be allocated.
+*/
+void* arena_allocAlign(Arena* ar, size_t size, size_t align)
+{
+    ArenaBlock* blk;
+    uintptr_t base = (uintptr_t) ar->base;
+    size_t start;
+
+    start = ALIGN_UP(base + ar->used, align) - base;
+    if (! ar->base || start > ar->avail || size > ar->avail - start) {
+        size_t need = size + ((align > ARENA_ALIGN) ? align : 0);
+        blk = arena_newBlock(ar, (need > ar->blockSize) ? need
+                                                        : ar->blockSize);
+        if (! blk)
+            return NULL;
+        blk->prev = ar->block;
+        ar->block = blk;
+        ar->prevUsed += ar->used;
+        ar->base  = BLOCK_MEM(blk);
+        ar->avail = blk->size;
+        base = (uintptr_t) ar->base;
+        start = ALIGN_UP(base, align) - base;
+    }
+
+    ar->last = start;
+    ar->used = start + size;
+    if (arena_inUse(ar) > ar->peak)
+        ar->peak = arena_inUse(ar);
+    return ar->base + start;
+}
+
+/**
+  Allocate memory aligned to ARENA_ALIGN bytes.
+
+  \return Pointer to memory or NULL if a new block could not be allocated.
+*/
+void* arena_alloc(Arena* ar, size_t size)
+{
+    return arena_allocAlign(ar, size, ARENA_ALIGN);
+}
+
+/**
+  Resize an allocation.  If ptr is the most recent allocation and there is
+  room in the current block then it is grown or shrunk in place, otherwise
+  new memory is allocated and oldSize bytes are copied.
+
+  \return Pointer to memory or NULL if a new block could not be allocated.
+*/
+void* arena_realloc(Arena* ar, void* ptr, size_t oldSize, size_t size)
+{
+    void* mem;
+
+    if (! ptr)
+        return arena_alloc(ar, size);
+
+    if ((char*) ptr == ar->base + ar->last && size <= ar->avail - ar->last) {
+        ar->used = ar->last + size;
+        if (arena_inUse(ar) > ar->peak)
+            ar->peak = arena_inUse(ar);
+        return ptr;
+    }
+
+    mem = arena_alloc(ar, size);
+    if (mem)
+        memcpy(mem, ptr, (oldSize < size) ? oldSize : size);
+    return mem;
+}
+
+/**
+  Get the current allocation position for use with arena_rollback().
+*/
+ArenaMark arena_mark(const Arena* ar)
+{
+    ArenaMark mark;
+    mark.block    = ar->block;
+    mark.used     = ar->used;
+    mark.prevUsed = ar->prevUsed;
+    return mark;
+}
+
+/**
+  Release all allocations made since the mark was taken.  Any blocks added
+  after the mark are kept for reuse.
+*/
+void arena_rollback(Arena* ar, const ArenaMark* mark)
+{
+    ArenaBlock* blk;
+
+    while ((blk = ar->block) != mark->block) {
+        ar->block = blk->prev;
+        blk->prev = ar->spare;
+        ar->spare = blk;
+    }
+
+    if (blk) {
+        ar->base  = BLOCK_MEM(blk);
+        ar->avail = blk->size;
+    } else {
+        ar->base  = NULL;
+        ar->avail = 0;
+    }
+    ar->used = ar->last = mark->used;
+    ar->prevUsed = mark->prevUsed;
+}
+
+/**
+  Release all allocations.  The blocks are kept for reuse.
+*/
+void arena_reset(Arena* ar)
+{
+    ArenaMark mark;
+    memset(&mark, 0, sizeof(mark));
+    arena_rollback(ar, &mark);
+}
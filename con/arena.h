@@ -0,0 +1,79 @@
+#ifndef ARENA_H
+#define ARENA_H
+/*
+  Arena Allocator
+  Dedicated to the public domain.
+
+  A bump allocator for temporary data.  Memory is released all at once with
+  arena_reset() or back to a saved position with arena_rollback() rather
+  than per allocation.  When a block is full another is chained on, and
+  blocks released by a reset or rollback are kept for reuse until
+  arena_free() is called.
+
+  The containers in con/ can be placed in an arena by defining the
+  allocator hooks before including their header (or when compiling their
+  source file):
+
+    extern Arena* frameArena;
+    #define CON_MALLOC(size)        arena_alloc(frameArena, size)
+    #define CON_REALLOC(ptr, old, size) \
+                                    arena_realloc(frameArena, ptr, old, size)
+    #define CON_FREE(ptr)           ((void) (ptr))
+
+  Each hook is optional; the defaults in conAlloc.h use malloc, realloc, &
+  free.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct ArenaBlock ArenaBlock;
+
+typedef struct {
+    ArenaBlock* block;  // Current block.
+    ArenaBlock* spare;  // Released blocks available for reuse.
+    char*  base;        // Start of current block memory.
+    size_t used;        // Bytes used in current block.
+    size_t avail;       // Size of current block memory.
+    size_t last;        // Offset of the most recent allocation.
+    size_t prevUsed;    // Bytes used in the blocks before the current one.
+    size_t blockSize;   // Minimum size of new blocks.
+    size_t peak;        // Maximum bytes in use (including alignment).
+    uint32_t blockCount;
+    uint32_t flags;
+}
+Arena;
+
+typedef struct {
+    ArenaBlock* block;
+    size_t used;
+    size_t prevUsed;
+}
+ArenaMark;
+
+#define ARENA_ALIGN     16
+
+enum ArenaFlags {
+    ARENA_HUGE_PAGES = 1    // Use mmap with huge pages where available.
+};
+
+#define arena_inUse(ar)     ((ar)->prevUsed + (ar)->used)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void  arena_init(Arena*, size_t blockSize, uint32_t flags);
+void  arena_free(Arena*);
+void  arena_reset(Arena*);
+void* arena_alloc(Arena*, size_t size);
+void* arena_allocAlign(Arena*, size_t size, size_t align);
+void* arena_realloc(Arena*, void* ptr, size_t oldSize, size_t size);
+ArenaMark arena_mark(const Arena*);
+void  arena_rollback(Arena*, const ArenaMark*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ARENA_H
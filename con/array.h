@@ -1,5 +1,5 @@
 /*
-  C Resizable Array Template (version 1.3)
+  C Resizable Array Template (version 1.4)
   Written and dedicated to the public domain in 2023 by Karl Robillard.
 
   Example Usage:
@@ -11,10 +11,15 @@
 
     #include "array.h"
     ARRAY_APPEND(myarr, MyArray, MyArrayElement)
+
+  Memory is managed with the CON_MALLOC, CON_REALLOC, & CON_FREE macros
+  which can be defined before including array.h (see conAlloc.h).
 */
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
+#include "conAlloc.h"
 
 #define array_init(ap) \
     ap->data = NULL; \
@@ -24,16 +29,19 @@
     arr.data = NULL; \
     arr.used = arr.avail = 0
 
-#define array_free(ap) free((ap)->data)
-#define array_freer(arr) free(arr.data)
+#define array_free(ap) CON_FREE((ap)->data)
+#define array_freer(arr) CON_FREE(arr.data)
 
 #define ARRAY_APPEND(PRE, AT, ET) \
 void PRE ## _reserve(AT* ap, size_t len) { \
     if (len > ap->avail) { \
+        size_t old = ap->avail; \
         ap->avail *= 2; \
         if (ap->avail < len) \
             ap->avail = (len < 8) ? 8 : len; \
-        ap->data = (ET*) realloc(ap->data, sizeof(ET) * ap->avail); \
+        ap->data = (ET*) CON_REALLOC(ap->data, sizeof(ET) * old, \
+                                     sizeof(ET) * ap->avail); \
+        (void) old;     /* Unused by the default CON_REALLOC. */ \
         assert(ap->data); \
     } \
 } \
@@ -59,10 +67,115 @@ void PRE ## _remove(AT* ap, size_t pos, size_t count) { \
         ap->used = pos; \
 }
 
+/*
+  When ET is an integer, enum, or pointer type of 1, 2, 4, or 8 bytes
+  ARRAY_FIND uses a SIMD scan on x86 with SSE2 or AVX2.  Other types (such
+  as floats, which cannot be compared bitwise) use a simple loop.
+*/
+#if defined(__GNUC__) && (defined(__AVX2__) || defined(__SSE2__))
+#ifndef ARRAY_FIND_VEC
+#define ARRAY_FIND_VEC
+#include <stdint.h>
+#include <immintrin.h>
+
+// Type classes 1 to 5 are integer, char, enum, bool, and pointer.
+#define ARRAY_FIND_IS_INT(ET) \
+    (sizeof(ET) <= 8 && (sizeof(ET) & (sizeof(ET) - 1)) == 0 && \
+     __builtin_classify_type(*(ET*) 0) >= 1 && \
+     __builtin_classify_type(*(ET*) 0) <= 5)
+
+#ifdef __AVX2__
+#define ARRAY_VEC            __m256i
+#define ARRAY_VEC_BYTES      32
+#define ARRAY_VEC_LOAD(p)    _mm256_loadu_si256((const __m256i*) (p))
+#define ARRAY_VEC_MASK(v)    (uint32_t) _mm256_movemask_epi8(v)
+#define ARRAY_VEC_SET8(n)    _mm256_set1_epi8(n)
+#define ARRAY_VEC_SET16(n)   _mm256_set1_epi16(n)
+#define ARRAY_VEC_SET32(n)   _mm256_set1_epi32(n)
+#define ARRAY_VEC_SET64(n)   _mm256_set1_epi64x(n)
+#define ARRAY_VEC_EQ8(a,b)   _mm256_cmpeq_epi8(a,b)
+#define ARRAY_VEC_EQ16(a,b)  _mm256_cmpeq_epi16(a,b)
+#define ARRAY_VEC_EQ32(a,b)  _mm256_cmpeq_epi32(a,b)
+#define ARRAY_VEC_EQ64(a,b)  _mm256_cmpeq_epi64(a,b)
+#else
+#define ARRAY_VEC            __m128i
+#define ARRAY_VEC_BYTES      16
+#define ARRAY_VEC_LOAD(p)    _mm_loadu_si128((const __m128i*) (p))
+#define ARRAY_VEC_MASK(v)    (uint32_t) _mm_movemask_epi8(v)
+#define ARRAY_VEC_SET8(n)    _mm_set1_epi8(n)
+#define ARRAY_VEC_SET16(n)   _mm_set1_epi16(n)
+#define ARRAY_VEC_SET32(n)   _mm_set1_epi32(n)
+#define ARRAY_VEC_SET64(n)   _mm_set1_epi64x(n)
+#define ARRAY_VEC_EQ8(a,b)   _mm_cmpeq_epi8(a,b)
+#define ARRAY_VEC_EQ16(a,b)  _mm_cmpeq_epi16(a,b)
+#define ARRAY_VEC_EQ32(a,b)  _mm_cmpeq_epi32(a,b)
+#ifdef __SSE4_1__
+#define ARRAY_VEC_EQ64(a,b)  _mm_cmpeq_epi64(a,b)
+#else
+static inline __m128i array_vecEq64(__m128i a, __m128i b) {
+    /* Both 32-bit halves must match. */
+    __m128i eq = _mm_cmpeq_epi32(a, b);
+    return _mm_and_si128(eq, _mm_shuffle_epi32(eq, _MM_SHUFFLE(2,3,0,1)));
+}
+#define ARRAY_VEC_EQ64(a,b)  array_vecEq64(a,b)
+#endif
+#endif
+
+/*
+  Compare a vector worth of elements per iteration.  A match sets all the
+  bytes of an element in the movemask so the lowest set bit gives the
+  position.
+*/
+#define ARRAY_FIND_VEC_IMP(BITS) \
+static inline int array_findVec ## BITS(const void* data, size_t n, \
+                                        const void* valp) { \
+    const uint ## BITS ## _t* it = (const uint ## BITS ## _t*) data; \
+    const size_t lanes = ARRAY_VEC_BYTES * 8 / BITS; \
+    uint ## BITS ## _t val; \
+    ARRAY_VEC key; \
+    uint32_t mask; \
+    size_t i = 0; \
+    memcpy(&val, valp, sizeof(val)); \
+    key = ARRAY_VEC_SET ## BITS(val); \
+    for (; i + lanes <= n; i += lanes) { \
+        mask = ARRAY_VEC_MASK(ARRAY_VEC_EQ ## BITS(ARRAY_VEC_LOAD(it + i), \
+                                                   key)); \
+        if (mask) \
+            return i + __builtin_ctz(mask) / (BITS / 8); \
+    } \
+    for (; i < n; ++i) { \
+        if (it[i] == val) \
+            return i; \
+    } \
+    return -1; \
+}
+
+ARRAY_FIND_VEC_IMP(8)
+ARRAY_FIND_VEC_IMP(16)
+ARRAY_FIND_VEC_IMP(32)
+ARRAY_FIND_VEC_IMP(64)
+
+static inline int array_findVec(const void* data, size_t n, const void* valp,
+                                size_t size) {
+    switch (size) {
+        case 1: return array_findVec8(data, n, valp);
+        case 2: return array_findVec16(data, n, valp);
+        case 4: return array_findVec32(data, n, valp);
+        default: return array_findVec64(data, n, valp);
+    }
+}
+#endif
+#else
+#define ARRAY_FIND_IS_INT(ET)   0
+#define array_findVec(data, n, valp, size)  -1
+#endif
+
 #define ARRAY_FIND(PRE, AT, ET) \
 int PRE ## _find(const AT* ap, ET val) { \
     const ET* it = ap->data; \
     const ET* end = it + ap->used; \
+    if (ARRAY_FIND_IS_INT(ET)) \
+        return array_findVec(ap->data, ap->used, &val, sizeof(ET)); \
     for (; it != end; ++it) { \
         if (*it == val) \
             return it - ap->data; \
@@ -98,3 +211,131 @@ void PRE ## _isort(ET* first, ET* end, \
         prev[1] = tmp; \
     } \
 }
+
+/*
+  These templates require the array to be sorted with compare_less.
+
+  size_t PRE_lowerBound(const AT*, const ET* val, compare_less, ctx)
+  Return position of the first element not less than val (or used).
+
+  int PRE_bsearch(const AT*, const ET* val, compare_less, ctx)
+  Return position of an element equal to val or -1 if none is found.
+  Requires ARRAY_LOWER_BOUND.
+
+  ET* PRE_insertSorted(AT*, const ET* val, int unique, compare_less, ctx)
+  Insert a copy of val at the lower bound position and return a pointer to
+  it.  If unique is non-zero and an equal element is present then that is
+  returned instead and the array is not changed.
+  Requires ARRAY_APPEND & ARRAY_LOWER_BOUND.
+*/
+#define ARRAY_LOWER_BOUND(PRE, AT, ET) \
+size_t PRE ## _lowerBound(const AT* ap, const ET* val, \
+    int (*compare_less)(const ET*,const ET*,void*), void* compare_ctx) { \
+    const ET* base = ap->data; \
+    size_t half, n = ap->used; \
+    while (n > 0) { \
+        half = n / 2; \
+        if (compare_less(base + half, val, compare_ctx)) { \
+            base += half + 1; \
+            n -= half + 1; \
+        } else \
+            n = half; \
+    } \
+    return base - ap->data; \
+}
+
+#define ARRAY_BSEARCH(PRE, AT, ET) \
+int PRE ## _bsearch(const AT* ap, const ET* val, \
+    int (*compare_less)(const ET*,const ET*,void*), void* compare_ctx) { \
+    size_t pos = PRE ## _lowerBound(ap, val, compare_less, compare_ctx); \
+    if (pos < ap->used && ! compare_less(val, ap->data + pos, compare_ctx)) \
+        return pos; \
+    return -1; \
+}
+
+#define ARRAY_INSERT_SORTED(PRE, AT, ET) \
+ET* PRE ## _insertSorted(AT* ap, const ET* val, int unique, \
+    int (*compare_less)(const ET*,const ET*,void*), void* compare_ctx) { \
+    ET tmp, *elem; \
+    size_t pos = PRE ## _lowerBound(ap, val, compare_less, compare_ctx); \
+    if (unique && pos < ap->used && \
+        ! compare_less(val, ap->data + pos, compare_ctx)) \
+        return ap->data + pos; \
+    tmp = *val;     /* val may be in the array which can be moved. */ \
+    PRE ## _append(ap, 1); \
+    elem = ap->data + pos; \
+    memmove(elem + 1, elem, sizeof(ET) * (ap->used - 1 - pos)); \
+    *elem = tmp; \
+    return elem; \
+}
+
+/*
+  ARRAY_SORT generates a stable merge sort.  Runs of ARRAY_SORT_RUN elements
+  are binary insertion sorted and then merged bottom-up.  Merges of runs
+  which are already in order are skipped, so sorted input is O(n).
+*/
+#ifndef ARRAY_SORT_RUN
+#define ARRAY_SORT_RUN  16
+#endif
+
+#define ARRAY_SORT(PRE, ET) \
+static void PRE ## _binsort(ET* first, ET* end, \
+    int (*compare_less)(const ET*,const ET*,void*), void* compare_ctx) { \
+    ET tmp, *it, *lo, *hi, *mid; \
+    for (it = first + 1; it < end; ++it) { \
+        tmp = *it; \
+        /* Find the position after any equal elements. */ \
+        lo = first; \
+        hi = it; \
+        while (lo < hi) { \
+            mid = lo + (hi - lo) / 2; \
+            if (compare_less(&tmp, mid, compare_ctx)) \
+                hi = mid; \
+            else \
+                lo = mid + 1; \
+        } \
+        if (lo != it) { \
+            memmove(lo + 1, lo, sizeof(ET) * (it - lo)); \
+            *lo = tmp; \
+        } \
+    } \
+} \
+void PRE ## _sort(ET* first, ET* end, \
+    int (*compare_less)(const ET*,const ET*,void*), void* compare_ctx) { \
+    ET *buf, *a, *b, *bend, *t, *tend; \
+    size_t n = end - first; \
+    size_t i, run; \
+    for (i = 0; i < n; i += ARRAY_SORT_RUN) { \
+        PRE ## _binsort(first + i, (n - i > ARRAY_SORT_RUN) ? \
+                        first + i + ARRAY_SORT_RUN : end, \
+                        compare_less, compare_ctx); \
+    } \
+    if (n <= ARRAY_SORT_RUN) \
+        return; \
+    /* Only the left run is copied out, so the buffer needs to hold the \
+       longest left run. */ \
+    for (run = ARRAY_SORT_RUN; run * 2 < n; run *= 2) ; \
+    buf = (ET*) CON_MALLOC(sizeof(ET) * run); \
+    assert(buf); \
+    for (run = ARRAY_SORT_RUN; run < n; run *= 2) { \
+        for (i = 0; i + run < n; i += 2 * run) { \
+            a = first + i; \
+            b = a + run; \
+            bend = (n - i > 2 * run) ? b + run : end; \
+            if (! compare_less(b, b - 1, compare_ctx)) \
+                continue; \
+            memcpy(buf, a, sizeof(ET) * run); \
+            t = buf; \
+            tend = buf + run; \
+            while (t != tend && b != bend) { \
+                if (compare_less(b, t, compare_ctx)) \
+                    *a++ = *b++; \
+                else \
+                    *a++ = *t++; \
+            } \
+            while (t != tend) \
+                *a++ = *t++; \
+        } \
+    } \
+    CON_FREE(buf); \
+}
@@ -0,0 +1,22 @@
+/*
+  Container Allocator Hooks
+  Dedicated to the public domain.
+
+  The con/ containers allocate memory with the CON_MALLOC, CON_REALLOC, &
+  CON_FREE macros.  Any of these can be defined before including a
+  container header (or when compiling its source file) to use another
+  allocator (see arena.h).  Those left undefined use malloc, realloc, &
+  free.
+*/
+
+#include <stdlib.h>
+
+#ifndef CON_MALLOC
+#define CON_MALLOC(size)            malloc(size)
+#endif
+#ifndef CON_REALLOC
+#define CON_REALLOC(ptr, old, size) realloc(ptr, size)
+#endif
+#ifndef CON_FREE
+#define CON_FREE(ptr)               free(ptr)
+#endif
@@ -1,5 +1,5 @@
 /*
-  C Fixed-Size Pool Template (version 0.5)
+  C Fixed-Size Pool Template (version 0.6)
   Copyright 2024  Karl Robillard.
   SPDX-License-Identifier: MIT
 
@@ -21,22 +21,135 @@
     #define FPOOL_SET_FREE(it)  ((it)->inUse = 0)
     #define FPOOL_IS_FREE(it)   ((it)->inUse == 0)
     FPOOL_IMPLEMENT(mypool, MyPool, MyPoolItem)
+
+  FPOOL_DENSE_IMPLEMENT makes the same pool but also keeps a dense array
+  of live item ids so they can be visited without testing every slot up to
+  used.  The pool struct must then have these members:
+
+        int* live;          // Live ids followed by their live positions.
+        uint32_t liveCount;
+
+    FPOOL_DENSE_IMPLEMENT(mydpool, MyDensePool, MyPoolItem)
+
+    for (i = 0; i < pool.liveCount; ++i)
+        process(fpool_liveItem(&pool, i));
+
+  Items of a FPOOL_IMPLEMENT or FPOOL_DENSE_IMPLEMENT pool can be
+  referenced with 32-bit handles which hold the item id and a generation
+  count.  The item struct must have an unsigned field for the generation,
+  which is named by FPOOL_GEN.  This must be defined before including
+  fpool.h so that PRE_defragment keeps the generation with each slot rather
+  than moving it with the item.
+
+    #define FPOOL_GEN  gen
+    #include "fpool.h"
+    ...
+    FPOOL_HANDLE_IMPLEMENT(mypool, MyPool, MyPoolItem)
+
+  FPOOL_ATOMIC_IMPLEMENT makes a pool which can be used from multiple
+  threads without locking (C11 atomics are required).  The FPOOL_NEXT
+  field must be declared as _Atomic int.
+
+    typedef struct {
+        MyPoolItem* data;
+        size_t avail;
+        _Atomic uint64_t freeHead;
+    } MyAtomicPool;
+
+    FPOOL_ATOMIC_IMPLEMENT(myapool, MyAtomicPool, MyPoolItem)
+
+  A pool which grows by adding blocks of (1 << FPOOL_BLOCK_SHIFT) items can
+  be made with FPOOL_CHUNKED_IMPLEMENT.  Items never move so pointers to
+  them remain valid.  Items are accessed by id with fpool_item().
+
+    typedef struct {
+        MyPoolItem** blocks;
+        size_t used, avail;
+        int firstFree;
+    } MyChunkedPool;
+
+    FPOOL_CHUNKED_IMPLEMENT(mycpool, MyChunkedPool, MyPoolItem)
 */
 
 #include <stdlib.h>
+#include <string.h>
+#include "conAlloc.h"
 
 #ifndef FPOOL_TERM
 #define FPOOL_TERM    -1
 #endif
 
+#ifndef FPOOL_BLOCK_SHIFT
+#define FPOOL_BLOCK_SHIFT   8
+#endif
+#define FPOOL_BLOCK_SIZE    (1 << FPOOL_BLOCK_SHIFT)
+#define FPOOL_BLOCK_MASK    (FPOOL_BLOCK_SIZE - 1)
+
+/* Dense pools maintain the live array; plain pools use the empty
+   FPOOL_NOLIVE versions. */
+#define FPOOL_LIVE_INIT(pp, max) \
+    pp->live = (int*) CON_MALLOC(2 * (max) * sizeof(int)); \
+    pp->liveCount = 0
+#define FPOOL_LIVE_FREE(pp) \
+    CON_FREE(pp->live); \
+    pp->live = NULL; \
+    pp->liveCount = 0
+#define FPOOL_LIVE_CLEAR(pp)    pp->liveCount = 0
+#define FPOOL_LIVE_ADD(pp, id) \
+    pp->live[pp->avail + id] = pp->liveCount; \
+    pp->live[pp->liveCount++] = id
+#define FPOOL_LIVE_REMOVE(pp, id) { \
+    int pos_ = pp->live[pp->avail + id]; \
+    int end_ = pp->live[--pp->liveCount]; \
+    pp->live[pos_] = end_; \
+    pp->live[pp->avail + end_] = pos_; \
+}
+#define FPOOL_NOLIVE_INIT(pp, max)
+#define FPOOL_NOLIVE_FREE(pp)
+#define FPOOL_NOLIVE_CLEAR(pp)
+#define FPOOL_NOLIVE_ADD(pp, id)
+#define FPOOL_NOLIVE_REMOVE(pp, id)
+
+#ifdef FPOOL_GEN
+/* Slots keep their own generation, which changes when an item moves in or
+   out, so no handle can resolve to a different item after a move. */
+#define FPOOL_MOVE(dst, src) { \
+    uint32_t dgen_ = (dst)->FPOOL_GEN; \
+    uint32_t sgen_ = (src)->FPOOL_GEN; \
+    *(dst) = *(src); \
+    (dst)->FPOOL_GEN = (dgen_ + 1) & FPOOL_GEN_MASK; \
+    (src)->FPOOL_GEN = (sgen_ + 1) & FPOOL_GEN_MASK; \
+}
+#else
+#define FPOOL_MOVE(dst, src)    *(dst) = *(src)
+#endif
+
+#define fpool_liveItem(pp, i)   ((pp)->data + (pp)->live[i])
+
+#define fpool_item(pp, id) \
+    ((pp)->blocks[(id) >> FPOOL_BLOCK_SHIFT] + ((id) & FPOOL_BLOCK_MASK))
+
+/*
+ * int PRE_defragment(AT*, int* remap)
+ * Move live items down into free slots so that all items below used are
+ * live.  If remap is not NULL it must hold used values and is set to the
+ * new id of each item (or FPOOL_TERM for slots which were free).  Returns
+ * the number of items moved.
+ */
 #define FPOOL_IMPLEMENT(PRE, AT, ET) \
-void PRE ## _clear(AT* pp) { \
-    pp->used = pp->firstFree = 0; \
-    if (pp->avail) { \
-        ET* it = pp->data; \
-        int end = pp->avail - 1; \
-        int i; \
-        for (i = 1; i < end; ++it, ++i) { \
+    FPOOL_POOL_IMP(PRE, AT, ET, FPOOL_NOLIVE)
+
+#define FPOOL_DENSE_IMPLEMENT(PRE, AT, ET) \
+    FPOOL_POOL_IMP(PRE, AT, ET, FPOOL_LIVE)
+
+#define FPOOL_POOL_IMP(PRE, AT, ET, LIVE) \
+static void PRE ## _linkFree(AT* pp, int start) { \
+    ET* it = pp->data + start; \
+    int end = pp->avail; \
+    int i; \
+    pp->firstFree = (start < end) ? start : FPOOL_TERM; \
+    if (start < end) { \
+        for (i = start + 1; i < end; ++it, ++i) { \
             FPOOL_SET_FREE(it); \
             it->FPOOL_NEXT = i; \
         } \
@@ -44,13 +157,21 @@ void PRE ## _clear(AT* pp) { \
         it->FPOOL_NEXT = FPOOL_TERM; \
     } \
 } \
+void PRE ## _clear(AT* pp) { \
+    pp->used = 0; \
+    PRE ## _linkFree(pp, 0); \
+    LIVE ## _CLEAR(pp); \
+} \
 void PRE ## _init(AT* pp, size_t max) { \
-    pp->data = calloc(max, sizeof(ET)); \
+    pp->data = (ET*) CON_MALLOC(max * sizeof(ET)); \
+    memset(pp->data, 0, max * sizeof(ET)); \
     pp->avail = max; \
+    LIVE ## _INIT(pp, max); \
     PRE ## _clear(pp); \
 } \
 void PRE ## _free(AT* pp) { \
-    free(pp->data); \
+    CON_FREE(pp->data); \
+    LIVE ## _FREE(pp); \
     pp->data = NULL; \
     pp->used = pp->avail = 0; \
 } \
@@ -60,10 +181,46 @@ ET* PRE ## _addItem(AT* pp) { \
         pp->firstFree = pp->data[id].FPOOL_NEXT; \
         if (id >= (int) pp->used) \
             pp->used = id + 1; \
+        LIVE ## _ADD(pp, id); \
         return pp->data + id; \
     } \
     return NULL; \
 } \
+int PRE ## _defragment(AT* pp, int* remap) { \
+    ET* data = pp->data; \
+    int lo = 0; \
+    int hi = pp->used - 1; \
+    int i, moved = 0; \
+    if (remap) { \
+        for (i = 0; i <= hi; ++i) \
+            remap[i] = FPOOL_IS_FREE(data + i) ? FPOOL_TERM : i; \
+    } \
+    for (;;) { \
+        while (lo < hi && ! FPOOL_IS_FREE(data + lo)) \
+            ++lo; \
+        while (lo < hi && FPOOL_IS_FREE(data + hi)) \
+            --hi; \
+        if (lo >= hi) \
+            break; \
+        FPOOL_MOVE(data + lo, data + hi); \
+        FPOOL_SET_FREE(data + hi); \
+        if (remap) \
+            remap[hi] = lo; \
+        ++moved; \
+        ++lo; \
+        --hi; \
+    } \
+    while (hi >= 0 && FPOOL_IS_FREE(data + hi)) \
+        --hi; \
+    pp->used = hi + 1; \
+    PRE ## _linkFree(pp, pp->used); \
+    /* The live ids are now simply 0 to used-1. */ \
+    LIVE ## _CLEAR(pp); \
+    for (i = 0; i <= hi; ++i) { \
+        LIVE ## _ADD(pp, i); \
+    } \
+    return moved; \
+} \
 void PRE ## _removeItem(AT* pp, ET* it) { \
     ET* data = pp->data; \
     int itPos, last; \
@@ -71,6 +228,7 @@ void PRE ## _removeItem(AT* pp, ET* it) { \
     FPOOL_SET_FREE(it); \
     it->FPOOL_NEXT = pp->firstFree; \
     pp->firstFree = itPos = it - data; \
+    LIVE ## _REMOVE(pp, itPos); \
     /* Adjust used downward to the next active value. */ \
     last = pp->used - 1; \
     if (itPos == last) { \
@@ -80,3 +238,316 @@ void PRE ## _removeItem(AT* pp, ET* it) { \
         pp->used = last + 1; \
     } \
 }
+
+/*
+ * void PRE_init(AT*, size_t reserve)
+ * Initialize pool and allocate blocks for at least reserve items.
+ *
+ * ET* PRE_addItem(AT*, int* id)
+ * Return a free item, adding a new block if none are left.  If id is not
+ * NULL then it is set to the item id.  Returns NULL if memory could not be
+ * allocated.
+ *
+ * void PRE_removeId(AT*, int id)
+ * void PRE_removeItem(AT*, ET*)
+ * Return an item to the pool.  PRE_addItem leaves the id in the FPOOL_NEXT
+ * field so PRE_removeItem is O(1) if that field is not changed while the
+ * item is in use.  Otherwise it must search the blocks (O(blocks)).
+ */
+#define FPOOL_CHUNKED_IMPLEMENT(PRE, AT, ET) \
+static void PRE ## _linkBlock(AT* pp, size_t b) { \
+    ET* it = pp->blocks[b]; \
+    int id = b * FPOOL_BLOCK_SIZE; \
+    int end = id + FPOOL_BLOCK_SIZE - 1; \
+    for (; id < end; ++it) { \
+        FPOOL_SET_FREE(it); \
+        it->FPOOL_NEXT = ++id; \
+    } \
+    FPOOL_SET_FREE(it); \
+    it->FPOOL_NEXT = pp->firstFree; \
+    pp->firstFree = b * FPOOL_BLOCK_SIZE; \
+} \
+static int PRE ## _grow(AT* pp) { \
+    size_t b = pp->avail >> FPOOL_BLOCK_SHIFT; \
+    ET* blk = (ET*) CON_MALLOC(FPOOL_BLOCK_SIZE * sizeof(ET)); \
+    ET** blocks; \
+    if (! blk) \
+        return 0; \
+    blocks = (ET**) CON_REALLOC(pp->blocks, b * sizeof(ET*), \
+                                (b + 1) * sizeof(ET*)); \
+    if (! blocks) { \
+        CON_FREE(blk); \
+        return 0; \
+    } \
+    memset(blk, 0, FPOOL_BLOCK_SIZE * sizeof(ET)); \
+    blocks[b] = blk; \
+    pp->blocks = blocks; \
+    pp->avail += FPOOL_BLOCK_SIZE; \
+    PRE ## _linkBlock(pp, b); \
+    return 1; \
+} \
+void PRE ## _clear(AT* pp) { \
+    size_t b = pp->avail >> FPOOL_BLOCK_SHIFT; \
+    pp->used = 0; \
+    pp->firstFree = FPOOL_TERM; \
+    while (b) \
+        PRE ## _linkBlock(pp, --b); \
+} \
+void PRE ## _init(AT* pp, size_t reserve) { \
+    pp->blocks = NULL; \
+    pp->used = pp->avail = 0; \
+    pp->firstFree = FPOOL_TERM; \
+    while (pp->avail < reserve && PRE ## _grow(pp)) ; \
+    PRE ## _clear(pp); \
+} \
+void PRE ## _free(AT* pp) { \
+    size_t b = pp->avail >> FPOOL_BLOCK_SHIFT; \
+    while (b) \
+        CON_FREE(pp->blocks[--b]); \
+    CON_FREE(pp->blocks); \
+    pp->blocks = NULL; \
+    pp->used = pp->avail = 0; \
+    pp->firstFree = FPOOL_TERM; \
+} \
+ET* PRE ## _addItem(AT* pp, int* idp) { \
+    int id = pp->firstFree; \
+    ET* it; \
+    if (id == FPOOL_TERM) { \
+        if (! PRE ## _grow(pp)) \
+            return NULL; \
+        id = pp->firstFree; \
+    } \
+    it = fpool_item(pp, id); \
+    pp->firstFree = it->FPOOL_NEXT; \
+    it->FPOOL_NEXT = id; \
+    if (id >= (int) pp->used) \
+        pp->used = id + 1; \
+    if (idp) \
+        *idp = id; \
+    return it; \
+} \
+void PRE ## _removeId(AT* pp, int id) { \
+    ET* it = fpool_item(pp, id); \
+    int last; \
+    /* Link into the free list. */ \
+    FPOOL_SET_FREE(it); \
+    it->FPOOL_NEXT = pp->firstFree; \
+    pp->firstFree = id; \
+    /* Adjust used downward to the next active value. */ \
+    last = pp->used - 1; \
+    if (id == last) { \
+        do { \
+            --last; \
+        } while (last >= 0 && FPOOL_IS_FREE(fpool_item(pp, last))); \
+        pp->used = last + 1; \
+    } \
+} \
+void PRE ## _removeItem(AT* pp, ET* it) { \
+    size_t b = pp->avail >> FPOOL_BLOCK_SHIFT; \
+    int id = it->FPOOL_NEXT; \
+    if (id >= 0 && id < (int) pp->used && fpool_item(pp, id) == it) { \
+        PRE ## _removeId(pp, id); \
+        return; \
+    } \
+    while (b) { \
+        ET* blk = pp->blocks[--b]; \
+        if (it >= blk && it < blk + FPOOL_BLOCK_SIZE) { \
+            PRE ## _removeId(pp, b * FPOOL_BLOCK_SIZE + (it - blk)); \
+            return; \
+        } \
+    } \
+}
+
+/*
+ * Handles use the low FPOOL_INDEX_BITS for the item id and the rest for
+ * the generation.  The pool must have less than (1 << FPOOL_INDEX_BITS)
+ * items.
+ *
+ * uint32_t PRE_handle(const AT*, const ET*)
+ * Return handle for a live item.
+ *
+ * ET* PRE_resolve(const AT*, uint32_t handle)
+ * Return the item for handle or NULL if the item has been removed.
+ *
+ * void PRE_removeHandle(AT*, uint32_t handle)
+ * void PRE_release(AT*, ET*)
+ * Remove an item and advance the slot generation so that any existing
+ * handles to it are invalidated.  Items must be removed with these rather
+ * than PRE_removeItem.  Invalid handles are ignored.
+ *
+ * PRE_defragment moves items and invalidates all handles to those moved, so
+ * handles to live items must be made again with PRE_handle using its remap
+ * table.  Handles to removed items stay invalid.
+ */
+#ifndef FPOOL_INDEX_BITS
+#define FPOOL_INDEX_BITS    20
+#endif
+#define FPOOL_INDEX_MASK    ((1u << FPOOL_INDEX_BITS) - 1)
+#define FPOOL_GEN_MASK      (0xffffffffu >> FPOOL_INDEX_BITS)
+#define FPOOL_NULL_HANDLE   0xffffffffu
+
+#define fpool_handleId(h)   ((h) & FPOOL_INDEX_MASK)
+
+#define FPOOL_HANDLE_IMPLEMENT(PRE, AT, ET) \
+uint32_t PRE ## _handle(const AT* pp, const ET* it) { \
+    uint32_t gen = it->FPOOL_GEN & FPOOL_GEN_MASK; \
+    return (gen << FPOOL_INDEX_BITS) | (uint32_t) (it - pp->data); \
+} \
+ET* PRE ## _resolve(const AT* pp, uint32_t handle) { \
+    uint32_t id = handle & FPOOL_INDEX_MASK; \
+    ET* it; \
+    if (id >= pp->used) \
+        return NULL; \
+    it = pp->data + id; \
+    if (FPOOL_IS_FREE(it) || \
+        (it->FPOOL_GEN & FPOOL_GEN_MASK) != (handle >> FPOOL_INDEX_BITS)) \
+        return NULL; \
+    return it; \
+} \
+void PRE ## _release(AT* pp, ET* it) { \
+    it->FPOOL_GEN = (it->FPOOL_GEN + 1) & FPOOL_GEN_MASK; \
+    PRE ## _removeItem(pp, it); \
+} \
+void PRE ## _removeHandle(AT* pp, uint32_t handle) { \
+    ET* it = PRE ## _resolve(pp, handle); \
+    if (it) \
+        PRE ## _release(pp, it); \
+}
+
+#if ! defined(__cplusplus) && defined(__STDC_VERSION__) && \
+    __STDC_VERSION__ >= 201112L && ! defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#include <stdint.h>
+
+/*
+ * The free list head holds the first free id in the low 32 bits and a tag
+ * in the high bits which is incremented on every change so that a stale
+ * compare-exchange fails (avoiding the ABA problem).  Items are never
+ * released to the system while the pool is in use so reading FPOOL_NEXT of
+ * an item which another thread has just taken is harmless.
+ *
+ * A thread can keep a FPoolCache of free ids to avoid touching the shared
+ * list on every call.  Half the cache is moved to or from the shared list
+ * when it is empty or full.
+ *
+ * int PRE_init(AT*, size_t max)
+ * void PRE_free(AT*)
+ * Must not be called while other threads are using the pool.  PRE_init
+ * returns zero if memory could not be allocated.
+ *
+ * ET* PRE_addItem(AT*)
+ * void PRE_removeItem(AT*, ET*)
+ *
+ * ET* PRE_addItemCached(AT*, FPoolCache*)
+ * void PRE_removeItemCached(AT*, FPoolCache*, ET*)
+ * void PRE_flushCache(AT*, FPoolCache*)
+ * The cache must be initialized with fpool_cacheInit() and flushed before
+ * the thread stops using it.
+ */
+#ifndef FPOOL_CACHE_SIZE
+#define FPOOL_CACHE_SIZE    32
+#endif
+
+#ifndef FPOOL_CACHE_DEFINED
+#define FPOOL_CACHE_DEFINED
+typedef struct {
+    int count;
+    int id[FPOOL_CACHE_SIZE];
+} FPoolCache;
+#endif
+
+#define fpool_cacheInit(fc)     (fc)->count = 0
+
+#define FPOOL_HEAD(tag, id) \
+    (((uint64_t) (tag) << 32) | (uint32_t) (id))
+
+#define FPOOL_ATOMIC_IMPLEMENT(PRE, AT, ET) \
+int PRE ## _init(AT* pp, size_t max) { \
+    ET* it; \
+    size_t i; \
+    pp->data = (ET*) CON_MALLOC(max * sizeof(ET)); \
+    if (! pp->data) \
+        max = 0; \
+    else \
+        memset(pp->data, 0, max * sizeof(ET)); \
+    pp->avail = max; \
+    for (i = 0, it = pp->data; i < max; ++i, ++it) { \
+        FPOOL_SET_FREE(it); \
+        atomic_init(&it->FPOOL_NEXT, (i + 1 < max) ? (int) i + 1 \
+                                                   : FPOOL_TERM); \
+    } \
+    atomic_init(&pp->freeHead, FPOOL_HEAD(0, max ? 0 : FPOOL_TERM)); \
+    return pp->data != NULL; \
+} \
+void PRE ## _free(AT* pp) { \
+    CON_FREE(pp->data); \
+    pp->data = NULL; \
+    pp->avail = 0; \
+    atomic_store(&pp->freeHead, FPOOL_HEAD(0, FPOOL_TERM)); \
+} \
+static void PRE ## _pushChain(AT* pp, int first, ET* last) { \
+    uint64_t head = atomic_load_explicit(&pp->freeHead, \
+                                         memory_order_relaxed); \
+    do { \
+        atomic_store_explicit(&last->FPOOL_NEXT, (int) (uint32_t) head, \
+                              memory_order_relaxed); \
+    } while (! atomic_compare_exchange_weak_explicit(&pp->freeHead, &head, \
+                FPOOL_HEAD((head >> 32) + 1, first), \
+                memory_order_release, memory_order_relaxed)); \
+} \
+ET* PRE ## _addItem(AT* pp) { \
+    uint64_t head = atomic_load_explicit(&pp->freeHead, \
+                                         memory_order_acquire); \
+    int id, next; \
+    do { \
+        id = (int) (uint32_t) head; \
+        if (id == FPOOL_TERM) \
+            return NULL; \
+        next = atomic_load_explicit(&pp->data[id].FPOOL_NEXT, \
+                                    memory_order_relaxed); \
+    } while (! atomic_compare_exchange_weak_explicit(&pp->freeHead, &head, \
+                FPOOL_HEAD((head >> 32) + 1, next), \
+                memory_order_acquire, memory_order_acquire)); \
+    return pp->data + id; \
+} \
+void PRE ## _removeItem(AT* pp, ET* it) { \
+    FPOOL_SET_FREE(it); \
+    PRE ## _pushChain(pp, it - pp->data, it); \
+} \
+ET* PRE ## _addItemCached(AT* pp, FPoolCache* fc) { \
+    ET* it; \
+    if (fc->count == 0) { \
+        while (fc->count < FPOOL_CACHE_SIZE / 2) { \
+            it = PRE ## _addItem(pp); \
+            if (! it) \
+                break; \
+            fc->id[fc->count++] = it - pp->data; \
+        } \
+        if (fc->count == 0) \
+            return NULL; \
+    } \
+    return pp->data + fc->id[--fc->count]; \
+} \
+static void PRE ## _flushN(AT* pp, FPoolCache* fc, int n) { \
+    int i, first; \
+    if (n <= 0) \
+        return; \
+    /* Link cached ids into a chain and push it with one exchange. */ \
+    fc->count -= n; \
+    first = fc->id[fc->count]; \
+    for (i = fc->count + 1; i < fc->count + n; ++i) { \
+        atomic_store_explicit(&pp->data[fc->id[i - 1]].FPOOL_NEXT, \
+                              fc->id[i], memory_order_relaxed); \
+    } \
+    PRE ## _pushChain(pp, first, pp->data + fc->id[i - 1]); \
+} \
+void PRE ## _removeItemCached(AT* pp, FPoolCache* fc, ET* it) { \
+    FPOOL_SET_FREE(it); \
+    if (fc->count == FPOOL_CACHE_SIZE) \
+        PRE ## _flushN(pp, fc, FPOOL_CACHE_SIZE / 2); \
+    fc->id[fc->count++] = it - pp->data; \
+} \
+void PRE ## _flushCache(AT* pp, FPoolCache* fc) { \
+    PRE ## _flushN(pp, fc, fc->count); \
+}
+#endif
@@ -0,0 +1,176 @@
+/*
+  C Hash Map Template (version 1.0)
+  Dedicated to the public domain.
+
+  An open addressing hash map using linear probing.  Keys, values and hashes
+  are kept in flat arrays and removal shifts following entries back, so no
+  tombstones are needed.
+
+  Example Usage:
+
+    typedef struct {
+        MyKey* keys;
+        MyValue* vals;
+        uint32_t* hash;     // Zero for empty slots.
+        uint32_t used, mask;
+    } MyMap;
+
+    #include "hashmap.h"
+    HMAP_IMPLEMENT(mymap, MyMap, MyKey, MyValue)
+
+  Before including hashmap.h the HMAP_HASH(key) & HMAP_EQUAL(a,b) macros
+  can be defined to hash & compare keys.  By default murmurHash3_32() is
+  used on the key bytes and keys are compared with ==.
+
+  To iterate over all entries:
+
+    for (i = 0; i < hmap_slots(&map); ++i) {
+        if (map.hash[i])
+            process(map.keys[i], map.vals[i]);
+    }
+*/
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "conAlloc.h"
+
+#ifndef HMAP_HASH
+#include "murmurHash3.h"
+#define HMAP_HASH(key) \
+    murmurHash3_32((const uint8_t*) &(key), sizeof(key), 0)
+#endif
+#ifndef HMAP_EQUAL
+#define HMAP_EQUAL(a,b) ((a) == (b))
+#endif
+
+#define HMAP_FILLED     0x80000000
+#define HMAP_MIN_SLOTS  16
+
+#define hmap_init(mp) \
+    (mp)->keys = NULL; \
+    (mp)->vals = NULL; \
+    (mp)->hash = NULL; \
+    (mp)->used = (mp)->mask = 0
+
+#define hmap_free(mp)   CON_FREE((mp)->keys)
+#define hmap_slots(mp)  ((mp)->hash ? (mp)->mask + 1 : 0)
+
+/*
+ * void PRE_resize(MT*, uint32_t slots)
+ * Rehash all entries into a table of slots entries.  Slots must be a power
+ * of two larger than the number of entries used.
+ *
+ * void PRE_reserve(MT*, uint32_t count)
+ * Grow the table so that count entries can be held without a resize.
+ *
+ * VT* PRE_find(const MT*, KT key)
+ * Return pointer to the value for key or NULL if it is not in the map.
+ *
+ * VT* PRE_insert(MT*, KT key, int* created)
+ * Return pointer to the value for key, adding the key if needed.
+ * If the key is added then created is set to 1 and the caller must
+ * initialize the value, otherwise it is set to 0.
+ *
+ * int PRE_remove(MT*, KT key)
+ * Return 1 if key was removed or 0 if it was not found.
+ *
+ * void PRE_clear(MT*)
+ * Remove all entries.
+ */
+
+#define HMAP_IMPLEMENT(PRE, MT, KT, VT) \
+void PRE ## _resize(MT* mp, uint32_t slots) { \
+    KT* keys = mp->keys; \
+    VT* vals = mp->vals; \
+    uint32_t* hash = mp->hash; \
+    uint32_t i, j, h, oldSlots = hmap_slots(mp); \
+    uint8_t* mem; \
+    assert(slots && (slots & (slots - 1)) == 0 && slots > mp->used); \
+    mem = (uint8_t*) CON_MALLOC(slots * \
+                        (sizeof(KT) + sizeof(VT) + sizeof(uint32_t))); \
+    assert(mem); \
+    mp->keys = (KT*) mem; \
+    mp->vals = (VT*) (mem + slots * sizeof(KT)); \
+    mp->hash = (uint32_t*) (mem + slots * (sizeof(KT) + sizeof(VT))); \
+    mp->mask = slots - 1; \
+    memset(mp->hash, 0, slots * sizeof(uint32_t)); \
+    for (i = 0; i < oldSlots; ++i) { \
+        h = hash[i]; \
+        if (h) { \
+            for (j = h & mp->mask; mp->hash[j]; j = (j + 1) & mp->mask) ; \
+            mp->hash[j] = h; \
+            mp->keys[j] = keys[i]; \
+            mp->vals[j] = vals[i]; \
+        } \
+    } \
+    CON_FREE(keys); \
+} \
+void PRE ## _reserve(MT* mp, uint32_t count) { \
+    uint32_t slots = hmap_slots(mp); \
+    if (count * 4 > slots * 3) { \
+        if (slots < HMAP_MIN_SLOTS) \
+            slots = HMAP_MIN_SLOTS; \
+        while (count * 4 > slots * 3) \
+            slots *= 2; \
+        PRE ## _resize(mp, slots); \
+    } \
+} \
+VT* PRE ## _find(const MT* mp, KT key) { \
+    uint32_t h, i; \
+    if (! mp->used) \
+        return NULL; \
+    h = HMAP_HASH(key) | HMAP_FILLED; \
+    for (i = h & mp->mask; mp->hash[i]; i = (i + 1) & mp->mask) { \
+        if (mp->hash[i] == h && HMAP_EQUAL(mp->keys[i], key)) \
+            return mp->vals + i; \
+    } \
+    return NULL; \
+} \
+VT* PRE ## _insert(MT* mp, KT key, int* created) { \
+    uint32_t h, i = 0; \
+    h = HMAP_HASH(key) | HMAP_FILLED; \
+    if (mp->hash) { \
+        for (i = h & mp->mask; mp->hash[i]; i = (i + 1) & mp->mask) { \
+            if (mp->hash[i] == h && HMAP_EQUAL(mp->keys[i], key)) { \
+                *created = 0; \
+                return mp->vals + i; \
+            } \
+        } \
+    } \
+    /* The key is new; only now grow the table if it is full. */ \
+    if ((mp->used + 1) * 4 > hmap_slots(mp) * 3) { \
+        PRE ## _reserve(mp, mp->used + 1); \
+        for (i = h & mp->mask; mp->hash[i]; i = (i + 1) & mp->mask) ; \
+    } \
+    mp->hash[i] = h; \
+    mp->keys[i] = key; \
+    mp->used++; \
+    *created = 1; \
+    return mp->vals + i; \
+} \
+int PRE ## _remove(MT* mp, KT key) { \
+    uint32_t h, i, j, mask = mp->mask; \
+    VT* val = PRE ## _find(mp, key); \
+    if (! val) \
+        return 0; \
+    /* Shift back any following entries which can move into the gap. */ \
+    i = val - mp->vals; \
+    for (j = (i + 1) & mask; (h = mp->hash[j]); j = (j + 1) & mask) { \
+        if (((j - (h & mask)) & mask) >= ((j - i) & mask)) { \
+            mp->hash[i] = h; \
+            mp->keys[i] = mp->keys[j]; \
+            mp->vals[i] = mp->vals[j]; \
+            i = j; \
+        } \
+    } \
+    mp->hash[i] = 0; \
+    mp->used--; \
+    return 1; \
+} \
+void PRE ## _clear(MT* mp) { \
+    if (mp->hash) \
+        memset(mp->hash, 0, hmap_slots(mp) * sizeof(uint32_t)); \
+    mp->used = 0; \
+}
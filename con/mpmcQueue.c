@@ -0,0 +1,187 @@
+/*
+    mpmcQueue - A bounded lock-free queue for any number of threads.
+
+    This code may be used under the terms of the MIT license (see rqueue.c).
+*/
+/*
+    This is a C template for a fixed size queue which any number of threads
+    can push to and pop from without locking.  It requires C11 atomics.
+
+    To generate the source implementation:
+
+        #include "mpmcQueue.c"
+        MPMCQ_IMP(MyStruct)
+
+    If mpmcQueue.c is included in more than one file in a project then all
+    other inclusions must be preceeded by a "#define MPMCQ_NO_BASE" line.
+
+    To generate header declarations:
+
+        #include "mpmcQueue.h"
+        MPMCQ_DECLARE(MyStruct);
+
+    Each cell holds a sequence number along with the value (the design is
+    by Dmitry Vyukov).  A cell is free for the push of position pos when
+    its sequence equals pos, and holds a value for the pop of pos when its
+    sequence equals pos + 1.  Threads claim a position with a single
+    compare-exchange and then only touch their own cell, so producers and
+    consumers do not contend with each other.
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+#include "mpmcQueue.h"
+#include "conAlloc.h"
+
+#ifndef MPMCQ_SPINS
+#define MPMCQ_SPINS     64
+#endif
+
+#ifndef MPMCQ_NO_BASE
+/*
+  Initialize queue.  This is called by mpmcq_init_<TYPE>().  The first
+  member of each cell must be the _Atomic uint32_t sequence number.
+*/
+void mpmcq_initCells(MPMCQueue* q, uint32_t capacity, size_t cellSize)
+{
+    uint8_t* cell;
+    uint32_t i, size = 2;
+
+    if (capacity > MPMCQ_MAX_CAPACITY)
+        capacity = MPMCQ_MAX_CAPACITY;
+    while (size < capacity)
+        size *= 2;
+
+    memset(q, 0, sizeof(MPMCQueue));
+    q->cells = CON_MALLOC(size * cellSize);
+    assert(q->cells);
+    q->mask = size - 1;
+
+    cell = (uint8_t*) q->cells;
+    for (i = 0; i < size; ++i, cell += cellSize)
+        atomic_init((_Atomic uint32_t*) cell, i);
+    atomic_init(&q->enqueuePos, 0);
+    atomic_init(&q->dequeuePos, 0);
+}
+
+/**
+  Free queue memory.  All threads must be finished using the queue.
+*/
+void mpmcq_free(MPMCQueue* q)
+{
+    CON_FREE(q->cells);
+    q->cells = NULL;
+    q->mask = 0;
+}
+
+/*
+  Wait used by the blocking push & pop.  Spins briefly before giving up
+  the CPU to other threads.
+*/
+void mpmcq_wait(int* spins)
+{
+    if (++(*spins) < MPMCQ_SPINS)
+        return;
+    *spins = 0;
+#ifdef _WIN32
+    SwitchToThread();
+#else
+    sched_yield();
+#endif
+}
+#endif
+
+/*
+ * void mpmcq_init_<TYPE>(MPMCQueue*, uint32_t capacity)
+ * Initialize queue to hold capacity values (rounded up to a power of two
+ * and limited to MPMCQ_MAX_CAPACITY).
+ * This must be done before any threads use the queue.
+ *
+ * int mpmcq_tryPush_<TYPE>(MPMCQueue*, const TYPE* val)
+ * Copy val to the tail of the queue.  Return 1 if successful or 0 if the
+ * queue is full.
+ *
+ * int mpmcq_tryPop_<TYPE>(MPMCQueue*, TYPE* val)
+ * Copy the head value to val and remove it.  Return 1 if successful or 0
+ * if the queue is empty.
+ *
+ * void mpmcq_push_<TYPE>(MPMCQueue*, const TYPE* val)
+ * void mpmcq_pop_<TYPE>(MPMCQueue*, TYPE* val)
+ * Blocking versions which wait until there is room or a value.  These
+ * spin and yield rather than sleep, so are intended for queues which are
+ * rarely full or empty for long.
+ */
+
+#define MPMCQ_IMP(T) \
+typedef struct { \
+    _Atomic uint32_t seq; \
+    T value; \
+} mpmcq_cell_ ## T; \
+void mpmcq_init_ ## T(MPMCQueue* q, uint32_t capacity) { \
+    mpmcq_initCells(q, capacity, sizeof(mpmcq_cell_ ## T)); \
+} \
+int mpmcq_tryPush_ ## T(MPMCQueue* q, const T* val) { \
+    mpmcq_cell_ ## T* cell; \
+    uint32_t seq, pos; \
+    int32_t dif; \
+    pos = atomic_load_explicit(&q->enqueuePos, memory_order_relaxed); \
+    for (;;) { \
+        cell = ((mpmcq_cell_ ## T*) q->cells) + (pos & q->mask); \
+        seq = atomic_load_explicit(&cell->seq, memory_order_acquire); \
+        dif = (int32_t) (seq - pos); \
+        if (dif == 0) { \
+            if (atomic_compare_exchange_weak_explicit(&q->enqueuePos, \
+                    &pos, pos + 1, memory_order_relaxed, \
+                    memory_order_relaxed)) \
+                break; \
+        } else if (dif < 0) \
+            return 0; \
+        else \
+            pos = atomic_load_explicit(&q->enqueuePos, \
+                                       memory_order_relaxed); \
+    } \
+    cell->value = *val; \
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release); \
+    return 1; \
+} \
+int mpmcq_tryPop_ ## T(MPMCQueue* q, T* val) { \
+    mpmcq_cell_ ## T* cell; \
+    uint32_t seq, pos; \
+    int32_t dif; \
+    pos = atomic_load_explicit(&q->dequeuePos, memory_order_relaxed); \
+    for (;;) { \
+        cell = ((mpmcq_cell_ ## T*) q->cells) + (pos & q->mask); \
+        seq = atomic_load_explicit(&cell->seq, memory_order_acquire); \
+        dif = (int32_t) (seq - (pos + 1)); \
+        if (dif == 0) { \
+            if (atomic_compare_exchange_weak_explicit(&q->dequeuePos, \
+                    &pos, pos + 1, memory_order_relaxed, \
+                    memory_order_relaxed)) \
+                break; \
+        } else if (dif < 0) \
+            return 0; \
+        else \
+            pos = atomic_load_explicit(&q->dequeuePos, \
+                                       memory_order_relaxed); \
+    } \
+    *val = cell->value; \
+    atomic_store_explicit(&cell->seq, pos + q->mask + 1, \
+                          memory_order_release); \
+    return 1; \
+} \
+void mpmcq_push_ ## T(MPMCQueue* q, const T* val) { \
+    int spins = 0; \
+    while (! mpmcq_tryPush_ ## T(q, val)) \
+        mpmcq_wait(&spins); \
+} \
+void mpmcq_pop_ ## T(MPMCQueue* q, T* val) { \
+    int spins = 0; \
+    while (! mpmcq_tryPop_ ## T(q, val)) \
+        mpmcq_wait(&spins); \
+}
@@ -0,0 +1,44 @@
+#ifndef MPMCQUEUE_H
+#define MPMCQUEUE_H
+/*
+    mpmcQueue - A bounded lock-free queue for any number of threads.
+
+    This code may be used under the terms of the MIT license (see rqueue.c).
+*/
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MPMCQ_CACHE_LINE    64
+
+typedef struct {
+    _Alignas(MPMCQ_CACHE_LINE) _Atomic uint32_t enqueuePos;
+    _Alignas(MPMCQ_CACHE_LINE) _Atomic uint32_t dequeuePos;
+    _Alignas(MPMCQ_CACHE_LINE) void* cells;     // Read only after init.
+    uint32_t mask;
+} MPMCQueue;
+
+#define MPMCQ_DECLARE(TYPE) \
+    void mpmcq_init_ ## TYPE(MPMCQueue*, uint32_t capacity); \
+    int  mpmcq_tryPush_ ## TYPE(MPMCQueue*, const TYPE*); \
+    int  mpmcq_tryPop_ ## TYPE(MPMCQueue*, TYPE*); \
+    void mpmcq_push_ ## TYPE(MPMCQueue*, const TYPE*); \
+    void mpmcq_pop_ ## TYPE(MPMCQueue*, TYPE*);
+
+#define mpmcq_capacity(q)   ((q)->mask + 1)
+#define MPMCQ_MAX_CAPACITY  0x80000000u
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void mpmcq_initCells(MPMCQueue*, uint32_t capacity, size_t cellSize);
+void mpmcq_free(MPMCQueue*);
+void mpmcq_wait(int* spins);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // MPMCQUEUE_H
@@ -36,19 +36,32 @@
 
         #include "rqueue.h"
         RQUEUE_DECLARE(MyStruct);
+
+    The buffer size is always a power of two so that indices wrap with a
+    mask.
 */
 
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 #include "rqueue.h"
+#include "conAlloc.h"
 
 #ifdef RQUEUE_NO_BASE
 extern void rqueue_resize(RQueue* rb, int count, size_t elemSize);
+extern void rqueue_spans(const RQueue* rb, uint32_t pos, uint32_t n,
+                         size_t elemSize, RQueueSpans* span);
 #else
 void rqueue_resize(RQueue* rb, int count, size_t elemSize)
 {
-    void* newValues = malloc(count * elemSize);
+    void* newValues;
+    uint32_t size = 1;
+
+    while (size < (uint32_t) count)
+        size *= 2;
+    count = size;
+
+    newValues = CON_MALLOC(count * elemSize);
     assert(newValues);
 
     if (rb->used) {
@@ -66,11 +79,27 @@ void rqueue_resize(RQueue* rb, int count, size_t elemSize)
         rb->head = 0;
     }
 
-    free(rb->values);
+    CON_FREE(rb->values);
     rb->values = newValues;
     rb->avail = count;
 }
 
+/*
+  Set span to the n values starting at pos, which may wrap around the end
+  of the buffer.
+*/
+void rqueue_spans(const RQueue* rb, uint32_t pos, uint32_t n,
+                  size_t elemSize, RQueueSpans* span)
+{
+    uint32_t len = rb->avail - pos;
+    if (len > n)
+        len = n;
+    span->ptr[0] = ((uint8_t*) rb->values) + pos * elemSize;
+    span->len[0] = len;
+    span->ptr[1] = rb->values;
+    span->len[1] = n - len;
+}
+
 void rqueue_init(RQueue* rb, int reserve, size_t elemSize)
 {
     memset(rb, 0, sizeof(RQueue));
@@ -85,7 +114,7 @@ void rqueue_clear(RQueue* rb)
 
 void rqueue_free(RQueue* rb)
 {
-    free(rb->values);
+    CON_FREE(rb->values);
     rb->values = NULL;
     rb->avail = rb->used = 0;
 }
@@ -97,6 +126,14 @@ void rqueue_free(RQueue* rb)
  *
  * TYPE* rqueue_removeHead_<TYPE>(RQueue*)
  * Return pointer to the previous head value.
+ *
+ * void rqueue_appendN_<TYPE>(RQueue*, uint32_t n, RQueueSpans*)
+ * Append n values which the caller must initialize.  They are located in
+ * one or two spans of the buffer.
+ *
+ * uint32_t rqueue_removeHeadN_<TYPE>(RQueue*, uint32_t n, RQueueSpans*)
+ * Remove up to n values from the head and return the number removed.
+ * The spans are valid until the next append.
  */
 
 #define RQUEUE_IMP(T) \
@@ -106,18 +143,33 @@ T* rqueue_append_ ## T(RQueue* rb) { \
         rqueue_resize(rb, 8, sizeof(T)); \
     else if (rb->used == rb->avail) \
         rqueue_resize(rb, rb->avail * 2, sizeof(T)); \
-    next = (rb->head + rb->used) % rb->avail; \
+    next = (rb->head + rb->used) & (rb->avail - 1); \
     rb->used++; \
     return ((T*) rb->values) + next; \
 } \
 T* rqueue_removeHead_ ## T(RQueue* rb) { \
-    uint32_t cur, next; \
+    uint32_t cur; \
     if (rb->used) { \
         rb->used--; \
         cur = rb->head; \
-        next = cur + 1; \
-        rb->head = (next >= rb->avail) ? 0 : next; \
+        rb->head = (cur + 1) & (rb->avail - 1); \
         return ((T*) rb->values) + cur; \
     } \
     return NULL; \
+} \
+void rqueue_appendN_ ## T(RQueue* rb, uint32_t n, RQueueSpans* span) { \
+    if (rb->used + n > rb->avail) \
+        rqueue_resize(rb, rb->used + n, sizeof(T)); \
+    rqueue_spans(rb, (rb->head + rb->used) & (rb->avail - 1), n, \
+                 sizeof(T), span); \
+    rb->used += n; \
+} \
+uint32_t rqueue_removeHeadN_ ## T(RQueue* rb, uint32_t n, \
+                                  RQueueSpans* span) { \
+    if (n > rb->used) \
+        n = rb->used; \
+    rqueue_spans(rb, rb->head, n, sizeof(T), span); \
+    rb->used -= n; \
+    rb->head = (rb->head + n) & (rb->avail - 1); \
+    return n; \
 }
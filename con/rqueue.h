@@ -16,9 +16,16 @@ typedef struct {
     uint32_t used;
 } RQueue;
 
+typedef struct {
+    void* ptr[2];
+    uint32_t len[2];    // Number of values in each span (len[1] may be 0).
+} RQueueSpans;
+
 #define RQUEUE_DECLARE(TYPE) \
     TYPE* rqueue_append_ ## TYPE(RQueue*); \
-    TYPE* rqueue_removeHead_ ## TYPE(RQueue*);
+    TYPE* rqueue_removeHead_ ## TYPE(RQueue*); \
+    void rqueue_appendN_ ## TYPE(RQueue*, uint32_t, RQueueSpans*); \
+    uint32_t rqueue_removeHeadN_ ## TYPE(RQueue*, uint32_t, RQueueSpans*);
 
 #ifdef __cplusplus
 extern "C" {
@@ -0,0 +1,132 @@
+/*
+    spscQueue - A lock-free queue for one producer and one consumer thread.
+
+    This code may be used under the terms of the MIT license (see rqueue.c).
+*/
+/*
+    This is a C template for a fixed size queue which one thread appends to
+    while another removes from, without locking.  It requires C11 atomics.
+
+    To generate the source implementation:
+
+        #include "spscQueue.c"
+        SPSCQ_IMP(MyStruct)
+
+    If spscQueue.c is included in more than one file in a project then all
+    other inclusions must be preceeded by a "#define SPSCQ_NO_BASE" line.
+
+    To generate header declarations:
+
+        #include "spscQueue.h"
+        SPSCQ_DECLARE(MyStruct);
+
+    Producer thread:
+
+        MyStruct* ms;
+        while (! (ms = spscq_append_MyStruct(&queue)))
+            ;   // Full; wait or do something else.
+        ms->field = value;
+        spscq_commitAppend(&queue);
+
+    Consumer thread:
+
+        MyStruct* ms;
+        if ((ms = spscq_head_MyStruct(&queue))) {
+            process(ms);
+            spscq_removeHead(&queue);
+        }
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spscQueue.h"
+#include "conAlloc.h"
+
+#ifndef SPSCQ_NO_BASE
+/**
+  Initialize queue.  This must be done before the producer & consumer
+  threads start using it.
+
+  \param capacity   Maximum number of values.  This is rounded up to a
+                    power of two and limited to SPSCQ_MAX_CAPACITY.
+*/
+void spscq_init(SPSCQueue* q, uint32_t capacity, size_t elemSize)
+{
+    uint32_t size = 1;
+    if (capacity > SPSCQ_MAX_CAPACITY)
+        capacity = SPSCQ_MAX_CAPACITY;
+    while (size < capacity)
+        size *= 2;
+
+    memset(q, 0, sizeof(SPSCQueue));
+    q->values = CON_MALLOC(size * elemSize);
+    assert(q->values);
+    q->mask = size - 1;
+    atomic_init(&q->head, 0);
+    atomic_init(&q->tail, 0);
+}
+
+/**
+  Free queue memory.  Both threads must be finished using the queue.
+*/
+void spscq_free(SPSCQueue* q)
+{
+    CON_FREE(q->values);
+    q->values = NULL;
+    q->mask = 0;
+}
+
+/**
+  Make the value returned by the last spscq_append_<TYPE>() available to
+  the consumer.  Called only by the producer.
+*/
+void spscq_commitAppend(SPSCQueue* q)
+{
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+}
+
+/**
+  Release the value returned by the last spscq_head_<TYPE>() back to the
+  producer.  Called only by the consumer.
+*/
+void spscq_removeHead(SPSCQueue* q)
+{
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+}
+#endif
+
+/*
+ * The head & tail are free running counters; the slot is the counter
+ * masked by the capacity.
+ *
+ * TYPE* spscq_append_<TYPE>(SPSCQueue*)
+ * Return pointer to the next free value which the producer must initialize
+ * and then pass on with spscq_commitAppend(), or NULL if the queue is full.
+ *
+ * TYPE* spscq_head_<TYPE>(SPSCQueue*)
+ * Return pointer to the oldest value which the consumer must release with
+ * spscq_removeHead() when done, or NULL if the queue is empty.
+ */
+
+#define SPSCQ_IMP(T) \
+T* spscq_append_ ## T(SPSCQueue* q) { \
+    uint32_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed); \
+    if (tail - q->headCache > q->mask) { \
+        q->headCache = atomic_load_explicit(&q->head, memory_order_acquire); \
+        if (tail - q->headCache > q->mask) \
+            return NULL; \
+    } \
+    return ((T*) q->values) + (tail & q->mask); \
+} \
+T* spscq_head_ ## T(SPSCQueue* q) { \
+    uint32_t head = atomic_load_explicit(&q->head, memory_order_relaxed); \
+    if (head == q->tailCache) { \
+        q->tailCache = atomic_load_explicit(&q->tail, memory_order_acquire); \
+        if (head == q->tailCache) \
+            return NULL; \
+    } \
+    return ((T*) q->values) + (head & q->mask); \
+}
@@ -0,0 +1,55 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+/*
+    spscQueue - A lock-free queue for one producer and one consumer thread.
+
+    This code may be used under the terms of the MIT license (see rqueue.c).
+*/
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SPSCQ_CACHE_LINE    64
+
+/*
+  The producer & consumer indices are kept on separate cache lines so that
+  the two threads do not invalidate each other's line on every operation.
+  Each side also keeps a copy of the other side's index and only reloads
+  it when the queue looks full (or empty).
+*/
+typedef struct {
+    // Producer.
+    _Alignas(SPSCQ_CACHE_LINE) _Atomic uint32_t tail;
+    uint32_t headCache;
+
+    // Consumer.
+    _Alignas(SPSCQ_CACHE_LINE) _Atomic uint32_t head;
+    uint32_t tailCache;
+
+    // Read only after init.
+    _Alignas(SPSCQ_CACHE_LINE) void* values;
+    uint32_t mask;
+} SPSCQueue;
+
+#define SPSCQ_DECLARE(TYPE) \
+    TYPE* spscq_append_ ## TYPE(SPSCQueue*); \
+    TYPE* spscq_head_ ## TYPE(SPSCQueue*);
+
+#define spscq_capacity(q)   ((q)->mask + 1)
+#define SPSCQ_MAX_CAPACITY  0x80000000u
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void spscq_init(SPSCQueue*, uint32_t capacity, size_t elemSize);
+void spscq_free(SPSCQueue*);
+void spscq_commitAppend(SPSCQueue*);
+void spscq_removeHead(SPSCQueue*);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SPSCQUEUE_H
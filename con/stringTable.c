@@ -10,14 +10,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include "stringTable.h"
+#include "conAlloc.h"
 
 #define DEFAULT_AVAIL   8
 #define MIN_STR_LEN     8
 
 static void sst_resize(StringTable* st, int count)
 {
-    StringEntry* newTable =
-        (StringEntry*) malloc(count * (sizeof(StringEntry) + st->allocLen));
+    StringEntry* newTable = (StringEntry*)
+        CON_MALLOC(count * (sizeof(StringEntry) + st->allocLen));
     assert(newTable);
 
     if (st->used) {
@@ -25,7 +26,7 @@ static void sst_resize(StringTable* st, int count)
         memcpy(newTable + count, sst_strings(st), st->storeUsed);
     }
 
-    free(st->table);
+    CON_FREE(st->table);
     st->table = newTable;
     st->avail = count;
 }
@@ -40,7 +41,7 @@ void sst_init(StringTable* st, int reserve, int averageLen)
 
 void sst_free(StringTable* st)
 {
-    free(st->table);
+    CON_FREE(st->table);
     st->table = NULL;
     st->avail = st->used = 0;
 }
@@ -0,0 +1,466 @@
+/*
+  Task Pool
+  Dedicated to the public domain.
+*/
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+#include "taskPool.h"
+
+typedef struct {
+    _Atomic int nextFree;
+    int inUse;
+    TaskFunc func;
+    TaskRangeFunc range;
+    void* arg;
+    TaskGroup* group;
+    uint32_t begin, end, grain;
+} Task;
+
+typedef struct {
+    Task* data;
+    size_t avail;
+    _Atomic uint64_t freeHead;
+} TaskStore;
+
+#include "fpool.h"
+#define FPOOL_NEXT  nextFree
+#define FPOOL_SET_FREE(it)  ((it)->inUse = 0)
+#define FPOOL_IS_FREE(it)   ((it)->inUse == 0)
+FPOOL_ATOMIC_IMPLEMENT(taskStore, TaskStore, Task)
+
+#define CACHE_LINE  64
+#define DEQUE_SIZE  1024        // Must be a power of two.
+#define DEQUE_MASK  (DEQUE_SIZE - 1)
+#define IDLE_SPINS  64
+
+struct TaskWorker {
+    // Owner end of the deque.
+    _Alignas(CACHE_LINE) _Atomic int64_t bottom;
+    FPoolCache cache;
+    TaskPoolState* state;
+    uint32_t seed;
+    int index;
+    pthread_t thread;
+
+    // Thief end of the deque.
+    _Alignas(CACHE_LINE) _Atomic int64_t top;
+    _Alignas(CACHE_LINE) _Atomic(Task*) deque[DEQUE_SIZE];
+};
+
+struct TaskPoolState {
+    TaskStore store;
+    TaskWorker* workers;
+    int workerCount;
+    _Atomic int queued;         // Tasks in all deques.
+    _Atomic int sleepers;
+    _Atomic int quit;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+};
+
+static _Thread_local TaskWorker* taskPool_worker;
+
+/*
+  Return the worker of the calling thread or NULL if it does not belong
+  to the pool.
+*/
+static TaskWorker* currentWorker(const TaskPool* pool)
+{
+    TaskWorker* w = taskPool_worker;
+    return (w && w->state == pool->state) ? w : NULL;
+}
+
+static int deque_push(TaskWorker* w, Task* task)
+{
+    int64_t b = atomic_load_explicit(&w->bottom, memory_order_relaxed);
+    int64_t t = atomic_load_explicit(&w->top, memory_order_acquire);
+    if (b - t >= DEQUE_SIZE)
+        return 0;
+    atomic_store_explicit(&w->deque[b & DEQUE_MASK], task,
+                          memory_order_relaxed);
+    atomic_store_explicit(&w->bottom, b + 1, memory_order_release);
+    return 1;
+}
+
+static Task* deque_take(TaskWorker* w)
+{
+    Task* task;
+    int64_t t;
+    int64_t b = atomic_load_explicit(&w->bottom, memory_order_relaxed) - 1;
+
+    atomic_store_explicit(&w->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    t = atomic_load_explicit(&w->top, memory_order_relaxed);
+    if (t > b) {
+        atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+        return NULL;
+    }
+
+    task = atomic_load_explicit(&w->deque[b & DEQUE_MASK],
+                                memory_order_relaxed);
+    if (t == b) {
+        // Last task; race any thieves for it.
+        if (! atomic_compare_exchange_strong_explicit(&w->top, &t, t + 1,
+                        memory_order_seq_cst, memory_order_relaxed))
+            task = NULL;
+        atomic_store_explicit(&w->bottom, b + 1, memory_order_relaxed);
+    }
+    return task;
+}
+
+static Task* deque_steal(TaskWorker* w)
+{
+    Task* task;
+    int64_t b;
+    int64_t t = atomic_load_explicit(&w->top, memory_order_acquire);
+
+    atomic_thread_fence(memory_order_seq_cst);
+    b = atomic_load_explicit(&w->bottom, memory_order_acquire);
+    if (t >= b)
+        return NULL;
+
+    task = atomic_load_explicit(&w->deque[t & DEQUE_MASK],
+                                memory_order_relaxed);
+    if (! atomic_compare_exchange_strong_explicit(&w->top, &t, t + 1,
+                    memory_order_seq_cst, memory_order_relaxed))
+        return NULL;
+    return task;
+}
+
+/*
+  Take a task from our own deque or steal one from another worker.
+*/
+static Task* worker_findTask(TaskWorker* w)
+{
+    TaskPoolState* st = w->state;
+    Task* task;
+    int i, n;
+
+    task = deque_take(w);
+    if (! task && st->workerCount > 1) {
+        // Start with a random victim so thieves spread out.
+        w->seed ^= w->seed << 13;
+        w->seed ^= w->seed >> 17;
+        w->seed ^= w->seed << 5;
+        n = w->seed % st->workerCount;
+        for (i = 0; i < st->workerCount && ! task; ++i, ++n) {
+            if (n == st->workerCount)
+                n = 0;
+            if (n != w->index)
+                task = deque_steal(st->workers + n);
+        }
+    }
+    if (task)
+        atomic_fetch_sub(&st->queued, 1);
+    return task;
+}
+
+/*
+  Queue a copy of the proto task, or run it now if the deque is full or
+  the caller is not a worker.
+*/
+static void task_spawn(TaskWorker* w, const Task* proto)
+{
+    TaskPoolState* st;
+    Task* task;
+
+    if (w) {
+        st = w->state;
+        task = taskStore_addItemCached(&st->store, &w->cache);
+        if (task) {
+            // Copy all but nextFree, which the pool reads atomically.
+            task->inUse = 1;
+            task->func  = proto->func;
+            task->range = proto->range;
+            task->arg   = proto->arg;
+            task->group = proto->group;
+            task->begin = proto->begin;
+            task->end   = proto->end;
+            task->grain = proto->grain;
+            atomic_fetch_add_explicit(&proto->group->pending, 1,
+                                      memory_order_relaxed);
+            if (deque_push(w, task)) {
+                atomic_fetch_add(&st->queued, 1);
+                if (atomic_load(&st->sleepers) > 0) {
+                    pthread_mutex_lock(&st->lock);
+                    pthread_cond_signal(&st->wake);
+                    pthread_mutex_unlock(&st->lock);
+                }
+                return;
+            }
+            atomic_fetch_sub_explicit(&proto->group->pending, 1,
+                                      memory_order_relaxed);
+            taskStore_removeItemCached(&st->store, &w->cache, task);
+        }
+    }
+
+    if (proto->range)
+        proto->range(proto->arg, proto->begin, proto->end);
+    else
+        proto->func(proto->arg);
+}
+
+/*
+  Split off the upper half of the range as a new task until the remainder
+  is no larger than the grain size, then process the remainder.
+*/
+static void task_runRange(TaskWorker* w, const Task* proto)
+{
+    Task part = *proto;
+    uint32_t mid;
+
+    if (w) {
+        while (part.end - part.begin > part.grain) {
+            mid = part.begin + (part.end - part.begin) / 2;
+            part.begin = mid;
+            task_spawn(w, &part);
+            part.end = mid;
+            part.begin = proto->begin;
+        }
+    }
+    part.range(part.arg, part.begin, part.end);
+}
+
+static void task_execute(TaskWorker* w, Task* task)
+{
+    TaskGroup* grp = task->group;
+
+    if (task->range) {
+        Task copy = *task;
+        taskStore_removeItemCached(&w->state->store, &w->cache, task);
+        task_runRange(w, &copy);
+    } else {
+        TaskFunc func = task->func;
+        void* arg = task->arg;
+        taskStore_removeItemCached(&w->state->store, &w->cache, task);
+        func(arg);
+    }
+    atomic_fetch_sub_explicit(&grp->pending, 1, memory_order_release);
+}
+
+static void* worker_main(void* arg)
+{
+    TaskWorker* w = (TaskWorker*) arg;
+    TaskPoolState* st = w->state;
+    Task* task;
+    int idle = 0;
+
+    taskPool_worker = w;
+    while (! atomic_load_explicit(&st->quit, memory_order_relaxed)) {
+        task = worker_findTask(w);
+        if (task) {
+            task_execute(w, task);
+            idle = 0;
+        } else if (++idle < IDLE_SPINS) {
+            sched_yield();
+        } else {
+            // Sleep until a task is queued.  The sleepers count is raised
+            // before checking queued so that task_spawn() cannot miss us.
+            pthread_mutex_lock(&st->lock);
+            atomic_fetch_add(&st->sleepers, 1);
+            while (atomic_load(&st->queued) <= 0 && ! atomic_load(&st->quit))
+                pthread_cond_wait(&st->wake, &st->lock);
+            atomic_fetch_sub(&st->sleepers, 1);
+            pthread_mutex_unlock(&st->lock);
+            idle = 0;
+        }
+    }
+    return NULL;
+}
+
+
+static int onlineCpuCount(void)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int) info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    return (int) sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    return 1;
+#endif
+}
+
+
+/**
+  Initialize pool and start threads.
+
+  \param threads  Number of workers including the calling thread.  If zero
+                  or less then the number of online CPUs is used.
+
+  \return Number of workers or zero if memory could not be allocated or a
+          thread could not be started.
+*/
+int taskPool_init(TaskPool* pool, int threads)
+{
+    TaskPoolState* st;
+    TaskWorker* w;
+    uintptr_t addr;
+    int i;
+
+    if (threads <= 0) {
+        threads = onlineCpuCount();
+        if (threads < 1)
+            threads = 1;
+    }
+
+    memset(pool, 0, sizeof(TaskPool));
+    // The state and workers share one block so that CON_MALLOC need not
+    // provide aligned memory; the workers are aligned to CACHE_LINE by hand.
+    st = (TaskPoolState*) CON_MALLOC(sizeof(TaskPoolState) + CACHE_LINE - 1 +
+                                     threads * sizeof(TaskWorker));
+    if (! st)
+        return 0;
+    addr = (uintptr_t) (st + 1);
+    addr = (addr + CACHE_LINE - 1) & ~((uintptr_t) CACHE_LINE - 1);
+    w = (TaskWorker*) addr;
+    memset(w, 0, threads * sizeof(TaskWorker));
+
+    // Every deque can be full with each worker cache holding the rest.
+    if (! taskStore_init(&st->store,
+                         threads * (DEQUE_SIZE + FPOOL_CACHE_SIZE))) {
+        CON_FREE(st);
+        return 0;
+    }
+    st->workers = w;
+    st->workerCount = threads;
+    atomic_init(&st->queued, 0);
+    atomic_init(&st->sleepers, 0);
+    atomic_init(&st->quit, 0);
+    pthread_mutex_init(&st->lock, NULL);
+    pthread_cond_init(&st->wake, NULL);
+
+    pool->workers = w;
+    pool->state = st;
+
+    for (i = 0; i < threads; ++i, ++w) {
+        atomic_init(&w->bottom, 0);
+        atomic_init(&w->top, 0);
+        fpool_cacheInit(&w->cache);
+        w->state = st;
+        w->seed = 0x9e3779b9 * (i + 1);
+        w->index = i;
+    }
+    taskPool_worker = pool->workers;
+
+    for (i = 1; i < threads; ++i) {
+        w = pool->workers + i;
+        if (pthread_create(&w->thread, NULL, worker_main, w)) {
+            // The running workers already use st->workerCount, so stop
+            // them rather than shrink the pool under them.
+            pool->threadCount = i;
+            taskPool_free(pool);
+            return 0;
+        }
+    }
+    pool->threadCount = threads;
+    return threads;
+}
+
+/**
+  Stop threads and free pool memory.  Any task groups must have been
+  waited on.
+*/
+void taskPool_free(TaskPool* pool)
+{
+    TaskPoolState* st = pool->state;
+    int i;
+
+    if (! st)
+        return;
+
+    pthread_mutex_lock(&st->lock);
+    atomic_store(&st->quit, 1);
+    pthread_cond_broadcast(&st->wake);
+    pthread_mutex_unlock(&st->lock);
+
+    for (i = 1; i < pool->threadCount; ++i)
+        pthread_join(pool->workers[i].thread, NULL);
+
+    if (taskPool_worker && taskPool_worker->state == st)
+        taskPool_worker = NULL;
+    pthread_mutex_destroy(&st->lock);
+    pthread_cond_destroy(&st->wake);
+    taskStore_free(&st->store);
+    CON_FREE(st);           // Also frees the workers.
+    memset(pool, 0, sizeof(TaskPool));
+}
+
+/**
+  Queue a task to be run by any worker.  Call taskPool_wait() on the group
+  to be sure it has finished.
+*/
+void taskPool_run(TaskPool* pool, TaskGroup* grp, TaskFunc func, void* arg)
+{
+    Task proto;
+
+    memset(&proto, 0, sizeof(proto));
+    proto.func  = func;
+    proto.arg   = arg;
+    proto.group = grp;
+    task_spawn(currentWorker(pool), &proto);
+}
+
+/**
+  Run queued tasks until all those in the group have finished.
+*/
+void taskPool_wait(TaskPool* pool, TaskGroup* grp)
+{
+    TaskWorker* w = currentWorker(pool);
+    Task* task;
+    int idle = 0;
+
+    while (atomic_load_explicit(&grp->pending, memory_order_acquire) > 0) {
+        task = w ? worker_findTask(w) : NULL;
+        if (task) {
+            task_execute(w, task);
+            idle = 0;
+        } else if (++idle >= IDLE_SPINS) {
+            sched_yield();
+            idle = 0;
+        }
+    }
+}
+
+/**
+  Call func on pieces of the range [begin, end) in parallel and wait for
+  them all to finish.
+
+  \param grain  Maximum number of indices passed to each func call.  If
+                zero then the range is split into about eight pieces per
+                thread.
+*/
+void taskPool_parallelFor(TaskPool* pool, uint32_t begin, uint32_t end,
+                          uint32_t grain, TaskRangeFunc func, void* arg)
+{
+    TaskGroup grp;
+    Task proto;
+
+    if (end <= begin)
+        return;
+    if (! grain) {
+        grain = (end - begin) / (pool->threadCount * 8);
+        if (! grain)
+            grain = 1;
+    }
+
+    taskGroup_init(&grp);
+    memset(&proto, 0, sizeof(proto));
+    proto.range = func;
+    proto.arg   = arg;
+    proto.group = &grp;
+    proto.begin = begin;
+    proto.end   = end;
+    proto.grain = grain;
+    task_runRange(currentWorker(pool), &proto);
+    taskPool_wait(pool, &grp);
+}
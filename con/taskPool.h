@@ -0,0 +1,60 @@
+#ifndef TASKPOOL_H
+#define TASKPOOL_H
+/*
+  Task Pool
+  Dedicated to the public domain.
+
+  A fixed set of threads which run small tasks for fork-join parallelism.
+  Each thread has a Chase-Lev deque; tasks are pushed & taken at the bottom
+  by the owner and idle threads steal from the top of the others.
+
+  The thread calling taskPool_init() becomes worker zero and must be the
+  one which calls the other functions (they may also be called from inside
+  tasks).  When called from any other thread tasks are run immediately.
+
+    TaskPool pool;
+    TaskGroup grp;
+
+    taskPool_init(&pool, 0);
+    taskGroup_init(&grp);
+    taskPool_run(&pool, &grp, jobA, argA);
+    taskPool_run(&pool, &grp, jobB, argB);
+    taskPool_wait(&pool, &grp);     // Runs tasks until jobA & B are done.
+
+    taskPool_parallelFor(&pool, 0, count, 0, processRange, data);
+    taskPool_free(&pool);
+
+  Requires pthreads and C11 atomics.
+*/
+
+#include <stdatomic.h>
+#include <stdint.h>
+
+typedef void (*TaskFunc)(void* arg);
+typedef void (*TaskRangeFunc)(void* arg, uint32_t begin, uint32_t end);
+
+typedef struct TaskWorker TaskWorker;
+typedef struct TaskPoolState TaskPoolState;
+
+typedef struct {
+    TaskWorker* workers;
+    TaskPoolState* state;
+    int threadCount;        // Number of workers, including the main thread.
+}
+TaskPool;
+
+typedef struct {
+    _Atomic int pending;    // Number of tasks not yet finished.
+}
+TaskGroup;
+
+#define taskGroup_init(grp)     atomic_init(&(grp)->pending, 0)
+
+int  taskPool_init(TaskPool*, int threads);
+void taskPool_free(TaskPool*);
+void taskPool_run(TaskPool*, TaskGroup*, TaskFunc, void* arg);
+void taskPool_wait(TaskPool*, TaskGroup*);
+void taskPool_parallelFor(TaskPool*, uint32_t begin, uint32_t end,
+                          uint32_t grain, TaskRangeFunc, void* arg);
+
+#endif  // TASKPOOL_H
@@ -19,6 +19,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "undo.h"
+#include "conAlloc.h"
 
 #define UV_SIZE sizeof(UndoValue)
 
@@ -35,11 +36,13 @@ int undo_init(UndoStack* us, uint32_t byteLimit)
     us->used = 0;
     us->pos = 0;
     us->byteLimit = byteLimit;
+    us->start = 0;
+    us->wrap = 0;
 
     if (bytes > initLimit)
         bytes = initLimit;
     us->avail = bytes / UV_SIZE;
-    us->stack = (UndoValue*) malloc(us->avail * UV_SIZE);
+    us->stack = (UndoValue*) CON_MALLOC(us->avail * UV_SIZE);
     if (! us->stack)
         return 0;
     us->stack[0].u = Undo_Term;
@@ -48,7 +51,7 @@ int undo_init(UndoStack* us, uint32_t byteLimit)
 
 void undo_free(UndoStack* us)
 {
-    free(us->stack);
+    CON_FREE(us->stack);
     us->stack = NULL;
 }
 
@@ -56,39 +59,81 @@ void undo_clear(UndoStack* us)
 {
     us->used = 0;
     us->pos = 0;
+    us->start = 0;
+    us->wrap = 0;
     us->stack[0].u = Undo_Term;
 }
 
-static void undo_discardHistory(UndoStack* us)
+/*
+ * Drop the oldest step.  Only the start index changes so this is O(1).
+ */
+static void undo_discardStep(UndoStack* us)
 {
-    const UndoValue* ep = us->stack;
-    const size_t eraseLimit = 1024*8;
-    size_t total, stepLen;
-    size_t eraseLen = us->byteLimit / 4;
-
-    if (eraseLen > eraseLimit)
-        eraseLen = eraseLimit;
-    eraseLen /= UV_SIZE;
-
-    // Walk steps until eraseLen is reached.
-    total = 0;
-    while (total < eraseLen) {
-        stepLen = ep->op.skipNext;
-        ep += stepLen;
-        total += stepLen;
-    }
+    uint32_t oldStart = us->start;
 
     // TODO: Allow user to process removed steps.
-    // us->eraseCallback(us->stack, total, us->user);
-    // An alternative to a callback is to abort undo_record() and have the
-    // user call an undo_erase() function.
+    // us->eraseCallback(us->stack + oldStart, us->user);
 
-    us->used -= total;
-    memcpy(us->stack, ep, us->used * UV_SIZE);
-    if (us->pos <= total)
-        us->pos = 0;
-    else
-        us->pos -= total;
+    us->start += us->stack[oldStart].op.skipNext;
+    if (us->wrap && us->start == us->wrap) {
+        us->start = 0;
+        us->wrap = 0;
+    }
+    if (us->pos == oldStart)
+        us->pos = us->start;
+}
+
+/*
+ * Move history to a new buffer of count values with the oldest step at
+ * index zero.
+ */
+static int undo_grow(UndoStack* us, uint32_t count)
+{
+    UndoValue* buf;
+    uint32_t len1, len2;
+
+    buf = (UndoValue*) CON_MALLOC(count * UV_SIZE);
+    if (! buf)
+        return 0;
+
+    if (us->wrap) {
+        len1 = us->wrap - us->start;
+        len2 = us->used + 1;
+        memcpy(buf, us->stack + us->start, len1 * UV_SIZE);
+        memcpy(buf + len1, us->stack, len2 * UV_SIZE);
+        if (us->pos < us->start)
+            us->pos += len1;
+        else
+            us->pos -= us->start;
+        us->used += len1;
+    } else {
+        memcpy(buf, us->stack + us->start,
+               (us->used - us->start + 1) * UV_SIZE);
+        us->pos  -= us->start;
+        us->used -= us->start;
+    }
+
+    CON_FREE(us->stack);
+    us->stack = buf;
+    us->avail = count;
+    us->start = 0;
+    us->wrap = 0;
+    return 1;
+}
+
+/*
+ * Return index where a step of stepLen values (plus a terminator) can be
+ * placed after the newest step or -1 if there is no room.
+ */
+static int undo_placeStep(const UndoStack* us, uint32_t stepLen)
+{
+    if (us->wrap)
+        return (us->used + stepLen < us->start) ? (int) us->used : -1;
+    if (us->used + stepLen < us->avail)
+        return us->used;
+    if (stepLen < us->start)
+        return 0;
+    return -1;
 }
 
 /**
@@ -98,7 +143,7 @@ static void undo_discardHistory(UndoStack* us)
  * position is discarded.
  *
  * If the history size grows beyond the byteLimit specified with undo_init()
- * then some previous history will be discarded.
+ * then the oldest steps are discarded.
  *
  * \param opcode    User identifer of undo step. Zero (Undo_Term) is reserved.
  * \param data      Data for undo step.
@@ -108,25 +153,48 @@ void undo_record(UndoStack* us, uint16_t opcode, const UndoValue* data,
                  int values)
 {
     UndoValue* top;
+    uint32_t maxCount = us->byteLimit / UV_SIZE;
+    uint32_t skipPrev;
     int stepLen = values + 1;
+    int at;
 
-    // Adding one for the Undo_Term.
-    if ((us->used + stepLen + 1) > us->avail) {
-        size_t count = us->avail * 2;
-        size_t bytes = (count * UV_SIZE) + UV_SIZE;
+    // Drop any redo steps.
+    if (us->pos == us->start) {
+        undo_clear(us);
+    } else {
+        if (us->wrap && us->pos >= us->start)
+            us->wrap = 0;
+        us->used = us->pos;
+    }
 
-        if (bytes > us->byteLimit)
-            undo_discardHistory(us);    // Assuming at least bytes remain.
+    while ((at = undo_placeStep(us, stepLen)) < 0) {
+        if (us->avail < maxCount) {
+            uint32_t count = us->avail * 2;
+            if (! undo_grow(us, (count < maxCount) ? count : maxCount))
+                return;
+        } else if (us->start != us->used) {
+            undo_discardStep(us);
+        } else if (us->used) {
+            undo_clear(us);         // All history was discarded.
+        } else if (! undo_grow(us, stepLen + 1)) {
+            return;                 // Step is larger than the byteLimit.
+        }
+    }
 
-        us->stack = (UndoValue*) realloc(us->stack, bytes);
-        us->avail = count;
+    skipPrev = us->stack[us->used].op.skipPrev;
+    if (at != (int) us->used) {
+        if (us->start == us->used)
+            us->start = 0;          // No history to wrap around.
+        else
+            us->wrap = us->used;    // Wrap around to the start of the buffer.
     }
 
-    top = us->stack + us->pos;
+    top = us->stack + at;
     top->op.code = opcode;
     top->op.skipNext = stepLen;
+    top->op.skipPrev = skipPrev;
     memcpy(++top, data, values * UV_SIZE);
-    us->pos += stepLen;
+    us->pos = at + stepLen;
     us->used = us->pos;
 
     // New terminator.
@@ -149,7 +217,7 @@ int undo_stepBack(UndoStack* us, const UndoValue** step)
     int stepLen;
     int adv;
 
-    if (! us->pos) {
+    if (us->pos == us->start) {
         *step = NULL;
         return Undo_AtEnd;
     }
@@ -160,10 +228,12 @@ int undo_stepBack(UndoStack* us, const UndoValue** step)
 
     top = us->stack + us->pos;
     stepLen = top->op.skipPrev;
+    if (us->pos == 0)
+        top = us->stack + us->wrap;     // Previous step ends at the wrap.
     *step = top - stepLen;
-    us->pos -= stepLen;
+    us->pos = *step - us->stack;
 
-    if (us->pos == 0)
+    if (us->pos == us->start)
         adv |= Undo_AdvancedToEnd;
     return adv;
 }
@@ -187,12 +257,14 @@ int undo_stepForward(UndoStack* us, const UndoValue** step)
     }
 
     adv = Undo_Advanced;
-    if (us->pos == 0)
+    if (us->pos == us->start)
         adv |= Undo_AdvancedFromStart;
 
     top = us->stack + us->pos;
     *step = top;
     us->pos += top->op.skipNext;
+    if (us->wrap && us->pos == us->wrap)
+        us->pos = 0;
 
     if (us->pos == us->used)
         adv |= Undo_AdvancedToEnd;
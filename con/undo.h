@@ -25,12 +25,20 @@ typedef union {
 }
 UndoValue;
 
+/*
+  The stack is a circular buffer.  The oldest step is at index start and
+  the terminator after the newest is at index used.  When a step does not
+  fit before the end of the buffer it is placed at index zero and wrap is
+  set to where the previous step ended.
+*/
 typedef struct {
     UndoValue* stack;
     uint32_t used;
     uint32_t avail;
     uint32_t pos;
     uint32_t byteLimit;
+    uint32_t start;
+    uint32_t wrap;          // Zero if the history does not wrap.
 }
 UndoStack;
 
@@ -45,6 +45,18 @@ GSC_IS_WALL() returns non-zero if the cell is a wall.
 Coordinates are range-checked, so the macros will only be used with valid
 values.
 
+If GSC_CLEAR_LIGHT(GSC_TYPE*, int x, int y) is also defined then the
+GscView functions are generated.  A GscView caches which octants of a view
+tested and lit each cell so that when walls change only the affected octants
+need to be recast.  Each GscView should use its own light grid.
+
+The gsc_castLights() function accumulates the light of many point lights
+into a separate GscLightGrid of intensity or RGB values.  GSC_SET_LIGHT is
+not used for this.  The falloff can be changed by defining
+GSC_LIGHT_FALLOFF(float distanceSquared, float radiusSquared) to return the
+light scale for a cell.  If GSC_THREADS is defined (pthreads is required)
+then gsc_castLightsMT() spreads the lights across threads.
+
 Here is an example of using the template:
 
     #define GSC_TYPE                MyGrid
@@ -76,6 +88,17 @@ Here is an example of using the template:
 
 #include <assert.h>
 #include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(GSC_THREADS) && ! defined(_WIN32)
+#include <pthread.h>
+#endif
+
+#ifndef GSC_LIGHT_FALLOFF
+#define GSC_LIGHT_FALLOFF(ds,rs)    (1.0f - (ds) / (rs))
+#endif
 
 // Struct for holding coordinate transform constants.
 typedef struct {
@@ -93,163 +116,460 @@ static const OctantTransform s_octantTransform[8] = {
     { 1,  0,  0, -1 }    // 7 SE-E
 };
 
+// Precomputed block corner slopes for all cells of an octant within a view
+// radius.  Each column X holds X + 1 cells with the left & right slopes of
+// cell Y at slope[X * (X + 1) + Y * 2].
+typedef struct {
+    float* slope;
+    float viewRadius;
+    int ceiling;
+} GscSlopeTable;
+
+// Cached view for incremental updates.  The mask holds a square of cells
+// centered on the viewer.  The low byte of each mask element has a bit set
+// for each octant which tested the cell for a wall and the high byte has a
+// bit set for each octant which lit the cell.
+typedef struct {
+    uint16_t* mask;
+    int pos[2];
+    float viewRadius;
+    int ceiling;        // Mask is (ceiling * 2 + 1) cells square.
+    int dirty;          // Octant bits which need to be recast.
+    const GscSlopeTable* slopes;    // Optional table for viewRadius.
+} GscView;
+
+#define GSC_TESTED(oct) (1 << (oct))
+#define GSC_LIT(oct)    (0x100 << (oct))
+#define GSC_MASK(view,x,y) \
+    view->mask[((y) - view->pos[1] + view->ceiling) * \
+               (view->ceiling * 2 + 1) + (x) - view->pos[0] + view->ceiling]
+
 /*
-    Recursively casts light into cells.  Operates on a single octant.
+    Fill a GscSlopeTable for use with gsc_computeVisibilityT().
+
+    \param viewRadius   Maximum view distance; can be a fractional value.
 
-    \param grid             The cell grid definition.
-    \param gridPos          The player's X,Y position within the grid.
-    \param viewRadius       The view radius; can be a fractional value.
+    \return Non-zero if successful or zero if memory allocation failed.
+*/
+static int gsc_slopeTableInit(GscSlopeTable* tab, float viewRadius)
+{
+    float* sp;
+    int xc, yc;
+
+    tab->viewRadius = viewRadius;
+    tab->ceiling = (int) ceilf(viewRadius);
+    tab->slope = sp = (float*)
+        malloc((tab->ceiling + 1) * (tab->ceiling + 2) * sizeof(float));
+    if (! sp)
+        return 0;
+
+    // Column zero is never cast, but is kept so the indexing is simple.
+    *sp++ = 0.0f;
+    *sp++ = 0.0f;
+    for (xc = 1; xc <= tab->ceiling; xc++) {
+        for (yc = 0; yc <= xc; yc++) {
+            *sp++ = (yc + 0.5f) / (xc - 0.5f);
+            *sp++ = (yc - 0.5f) / (xc + 0.5f);
+        }
+    }
+    return 1;
+}
+
+static void gsc_slopeTableFree(GscSlopeTable* tab)
+{
+    free(tab->slope);
+    tab->slope = NULL;
+}
+
+#ifndef GSC_STACK_SIZE
+#define GSC_STACK_SIZE  64
+#endif
+
+// Point light for gsc_castLights().
+typedef struct {
+    int pos[2];
+    float radius;
+    float color[3];     // Only color[0] is used for an intensity grid.
+} GscLight;
+
+// Light accumulation buffer covering a rectangle of grid cells.
+typedef struct {
+    float* light;       // w * h * channels values.
+    int x, y, w, h;
+    int channels;       // 1 (intensity) or 3 (RGB).
+} GscLightGrid;
+
+// Scan of a view area suspended at a wall while the area to the left of the
+// wall is cast.
+typedef struct {
+    int column;
+    int row;                // Next cell of the column to test.
+    float leftSlope;
+    float rightSlope;
+    float wallSlope;        // Right slope of the wall above row.
+} GscSpan;
+
+// Constants for casting light into a single octant.
+typedef struct {
+    GSC_TYPE* grid;
+    const int* gridPos;         // The player's X,Y position within the grid.
+    const OctantTransform* txfrm;
+    const float* slopes;        // GscSlopeTable slope array or NULL.
+    GscView* view;              // Cache to record the octant in or NULL.
+    GscLightGrid* accum;        // Light accumulation buffer or NULL.
+    const float* color;         // Light color when accum is set.
+    float viewRadius;           // The view radius; can be a fractional value.
+    int octant;                 // Index of txfrm in s_octantTransform.
+} GscCast;
+
+/*
+    Add light to a GscLightGrid cell if it lies within the grid rectangle.
+*/
+static void gsc_accumulate(const GscCast* cc, int x, int y, float distSq)
+{
+    GscLightGrid* lg = cc->accum;
+    float* lp;
+    float f;
+
+    x -= lg->x;
+    y -= lg->y;
+    if (x < 0 || x >= lg->w || y < 0 || y >= lg->h)
+        return;
+
+    f = GSC_LIGHT_FALLOFF(distSq, cc->viewRadius * cc->viewRadius);
+    lp = lg->light + (y * lg->w + x) * lg->channels;
+    lp[0] += cc->color[0] * f;
+    if (lg->channels == 3) {
+        lp[1] += cc->color[1] * f;
+        lp[2] += cc->color[2] * f;
+    }
+}
+
+/*
+    Casts light into cells.  Operates on a single octant.
+
+    When a wall splits the view area the scan of the current column is
+    pushed onto a stack of GscSpan and the part to the left of the wall is
+    cast first, then the scan is resumed.  Each span on the stack is in an
+    earlier column than the one above it, so no more than ceil(viewRadius)
+    spans are ever pending.  Up to GSC_STACK_SIZE spans are held on the C
+    stack; larger radii use a heap allocation and nothing is lit if that
+    fails.
+
+    \param cc               The grid, octant, and view constants.
     \param startColumn      Current column; pass 1 as initial value.
     \param leftViewSlope    Slope of the left (upper) view edge; pass 1.0 as
                             the initial value.
     \param rightViewSlope   Slope of the right (lower) view edge; pass 0.0 as
                             the initial value.
-    \param txfrm            Coordinate multipliers for the octant transform.
-
-    Maximum recursion depth is ceiling(viewRadius).
 */
-static void gsc_castLight(GSC_TYPE* grid, const int* gridPos, float viewRadius,
-        int startColumn, float leftViewSlope, float rightViewSlope,
-        const OctantTransform* txfrm)
+static void gsc_castLight(const GscCast* cc, int startColumn,
+                          float leftViewSlope, float rightViewSlope)
 {
+    GscSpan local[GSC_STACK_SIZE];
+    GscSpan* stack = local;
+    GscSpan* sp;
+
+    GSC_TYPE* grid = cc->grid;
+    const int* gridPos = cc->gridPos;
+    const OctantTransform* txfrm = cc->txfrm;
+    const float* slopes = cc->slopes;
+    GscView* view = cc->view;
+    int octant = cc->octant;
+
     // Used for distance test.
-    float viewRadiusSq = viewRadius * viewRadius;
+    float viewRadiusSq = cc->viewRadius * cc->viewRadius;
 
-    int viewCeiling = (int) ceilf(viewRadius);
+    int viewCeiling = (int) ceilf(cc->viewRadius);
 
     // Set true if the previous cell we encountered was blocked.
-    int prevWasBlocked = 0;
+    int prevWasBlocked;
 
     // As an optimization, when scanning past a block we keep track of the
     // rightmost corner (bottom-right) of the last one seen.  If the next cell
     // is empty, we can use this instead of having to compute the top-right
     // corner of the empty cell.
-    float savedRightSlope = -1;
+    float savedRightSlope;
 
     int xDim = GSC_XDIM(grid);
     int yDim = GSC_YDIM(grid);
     int currentCol, xc, yc;
+    int resume = 0;
 
-    assert(leftViewSlope >= rightViewSlope);
-
-    // Outer loop: walk across each column, stopping when we reach the
-    // visibility limit.
-    for (currentCol = startColumn; currentCol <= viewCeiling; currentCol++) {
-        xc = currentCol;
-
-        // Inner loop: walk down the current column.  We start at the top,
-        // where X==Y.
-        //
-        // TODO: we waste time walking across the entire column when the view
-        //   area is narrow.  Experiment with computing the possible range of
-        //   cells from the slopes, and iterate over that instead.
-
-        for (yc = currentCol; yc >= 0; yc--) {
-            // Translate local coordinates to grid coordinates.  For the
-            // various octants we need to invert one or both values, or swap
-            // X for Y.
-            int gridX = gridPos[0] + xc * txfrm->xx + yc * txfrm->xy;
-            int gridY = gridPos[1] + xc * txfrm->yx + yc * txfrm->yy;
-
-            // Range-check the values.  This lets us avoid the slope division
-            // for blocks that are outside the grid.
-            //
-            // Note that, while we will stop at a solid column of blocks, we
-            // do always start at the top of the column, which may be outside
-            // the grid if we're (say) checking the first octant while
-            // positioned at the north edge of the map.
-
-            if (gridX < 0 || gridX >= xDim || gridY < 0 || gridY >= yDim)
-                continue;
-
-            // Compute slopes to corners of current block.  We use the top-left
-            // and bottom-right corners.  If we were iterating through a
-            // quadrant, rather than an octant, we'd need to flip the corners
-            // we used when we hit the midpoint.
-            //
-            // Note these values will be outside the view angles for the
-            // blocks at the ends -- left value > 1, right value < 0.
+    if (viewCeiling > GSC_STACK_SIZE) {
+        stack = (GscSpan*) malloc(viewCeiling * sizeof(GscSpan));
+        if (! stack)
+            return;
+    }
+    sp = stack;
 
-            float leftBlockSlope  = (yc + 0.5f) / (xc - 0.5f);
-            float rightBlockSlope = (yc - 0.5f) / (xc + 0.5f);
+    currentCol = startColumn;
+    prevWasBlocked = 0;
+    savedRightSlope = -1;
 
-            // Check to see if the block is outside our view area.  Note that
-            // we allow a "corner hit" to make the block visible.  Changing
-            // the tests to >= / <= will reduce the number of cells visible
-            // through a corner (from a 3-wide swath to a single diagonal
-            // line), and affect how far you can see past a block as you
-            // approach it.  This is mostly a matter of personal preference.
+    while (1) {
+        assert(leftViewSlope >= rightViewSlope);
 
-            if (rightBlockSlope > leftViewSlope) {
-                // Block is above the left edge of our view area; skip.
-                continue;
-            } else if (leftBlockSlope < rightViewSlope) {
-                // Block is below the right edge of our view area; we're done.
-                break;
-            }
+        // Outer loop: walk across each column, stopping when we reach the
+        // visibility limit.
+        for (; currentCol <= viewCeiling; currentCol++) {
+            xc = currentCol;
 
-            // This cell is visible, given infinite vision range.  If it's
-            // also within our finite vision range, light it up.
+            // Inner loop: walk down the current column.  We start at the top
+            // of the view area, which is at most where X==Y.  The cells
+            // skipped are at least one row above the left view edge so the
+            // rounding of this estimate cannot skip any cell the slope test
+            // would pass.
             //
-            // To avoid having a single lit cell poking out N/S/E/W, use a
-            // fractional viewRadius, e.g. 8.5.
-            //
-            // TODO: we're testing the middle of the cell for visibility.  If
-            //  we tested the bottom-left corner, we could say definitively
-            //  that no part of the cell is visible, and reduce the view area as
-            //  if it were a wall.  This could reduce iteration at the corners.
-
-            float distanceSquared = xc * xc + yc * yc;
-            if (distanceSquared <= viewRadiusSq) {
-                GSC_SET_LIGHT(grid, gridX, gridY, distanceSquared);
-            }
+            // TODO: we still walk down past the right view edge until a cell
+            //   fails the slope test when the view area is narrow.
 
-            int curBlocked = GSC_IS_WALL(grid, gridX, gridY);
+            if (resume) {
+                // Continue below the wall where the scan was suspended.
+                resume = 0;
+            } else {
+                yc = (int) (leftViewSlope * (xc + 0.5f) + 0.5f) + 1;
+                if (yc > currentCol)
+                    yc = currentCol;
+            }
 
-            if (prevWasBlocked) {
-                if (curBlocked) {
-                    // Still traversing a column of walls.
-                    savedRightSlope = rightBlockSlope;
+            for (; yc >= 0; yc--) {
+                // Translate local coordinates to grid coordinates.  For the
+                // various octants we need to invert one or both values, or
+                // swap X for Y.
+                int gridX = gridPos[0] + xc * txfrm->xx + yc * txfrm->xy;
+                int gridY = gridPos[1] + xc * txfrm->yx + yc * txfrm->yy;
+
+                // Range-check the values.  This lets us avoid the slope
+                // division for blocks that are outside the grid.
+                //
+                // Note that, while we will stop at a solid column of blocks,
+                // we do always start at the top of the column, which may be
+                // outside the grid if we're (say) checking the first octant
+                // while positioned at the north edge of the map.
+
+                if (gridX < 0 || gridX >= xDim || gridY < 0 || gridY >= yDim)
+                    continue;
+
+                // Compute slopes to corners of current block.  We use the top-
+                // left and bottom-right corners.  If we were iterating through
+                // a quadrant, rather than an octant, we'd need to flip the
+                // corners we used when we hit the midpoint.
+                //
+                // Note these values will be outside the view angles for the
+                // blocks at the ends -- left value > 1, right value < 0.
+
+                float leftBlockSlope, rightBlockSlope;
+                if (slopes) {
+                    const float* tp = slopes + xc * (xc + 1) + yc * 2;
+                    leftBlockSlope  = tp[0];
+                    rightBlockSlope = tp[1];
                 } else {
-                    // Found the end of the column of walls.  Set the left
-                    // edge of our view area to the right corner of the last
-                    // wall we saw.
-                    prevWasBlocked = 0;
-                    leftViewSlope = savedRightSlope;
+                    leftBlockSlope  = (yc + 0.5f) / (xc - 0.5f);
+                    rightBlockSlope = (yc - 0.5f) / (xc + 0.5f);
                 }
-            } else {
-                if (curBlocked) {
-                    // Found a wall.  Split the view area, recursively
-                    // pursuing the part to the left.  The leftmost corner of
-                    // the wall we just found becomes the right boundary of
-                    // the view area.
-                    //
-                    // If this is the first block in the column, the slope of
-                    // the top-left corner will be greater than the initial
-                    // view slope (1.0).  Handle that here.
-
-                    if (leftBlockSlope <= leftViewSlope) {
-                        gsc_castLight(grid, gridPos, viewRadius, currentCol + 1,
-                                      leftViewSlope, leftBlockSlope, txfrm);
+
+                // Check to see if the block is outside our view area.  Note
+                // that we allow a "corner hit" to make the block visible.
+                // Changing the tests to >= / <= will reduce the number of
+                // cells visible through a corner (from a 3-wide swath to a
+                // single diagonal line), and affect how far you can see past a
+                // block as you approach it.  This is mostly a matter of
+                // personal preference.
+
+                if (rightBlockSlope > leftViewSlope) {
+                    // Block is above the left edge of our view area; skip.
+                    continue;
+                } else if (leftBlockSlope < rightViewSlope) {
+                    // Block is below the right edge of our view area; we're
+                    // done.
+                    break;
+                }
+
+                // This cell is visible, given infinite vision range.  If it's
+                // also within our finite vision range, light it up.
+                //
+                // To avoid having a single lit cell poking out N/S/E/W, use a
+                // fractional viewRadius, e.g. 8.5.
+                //
+                // TODO: we're testing the middle of the cell for visibility.
+                //   If we tested the bottom-left corner, we could say
+                //   definitively that no part of the cell is visible, and
+                //   reduce the view area as if it were a wall.  This could
+                //   reduce iteration at the corners.
+
+                float distanceSquared = xc * xc + yc * yc;
+                if (distanceSquared <= viewRadiusSq) {
+                    if (cc->accum) {
+                        // Axis & diagonal cells are shared with the
+                        // neighbouring octant, which is always even for
+                        // an odd octant.  Only the even one adds light.
+                        if (! (octant & 1) || (yc != 0 && yc != xc))
+                            gsc_accumulate(cc, gridX, gridY,
+                                           distanceSquared);
+                    } else {
+                        GSC_SET_LIGHT(grid, gridX, gridY, distanceSquared);
+                        if (view)
+                            GSC_MASK(view, gridX, gridY) |= GSC_LIT(octant);
                     }
+                }
 
-                    // Once that's done, we keep searching to the right (down
-                    // the column), looking for another opening.
-                    prevWasBlocked = 1;
-                    savedRightSlope = rightBlockSlope;
+                int curBlocked = GSC_IS_WALL(grid, gridX, gridY);
+                if (view)
+                    GSC_MASK(view, gridX, gridY) |= GSC_TESTED(octant);
+
+                if (prevWasBlocked) {
+                    if (curBlocked) {
+                        // Still traversing a column of walls.
+                        savedRightSlope = rightBlockSlope;
+                    } else {
+                        // Found the end of the column of walls.  Set the left
+                        // edge of our view area to the right corner of the
+                        // last wall we saw.
+                        prevWasBlocked = 0;
+                        leftViewSlope = savedRightSlope;
+                    }
+                } else {
+                    if (curBlocked) {
+                        // Found a wall.  Split the view area, saving the
+                        // scan down the column for later.  The leftmost
+                        // corner of the wall we just found becomes the right
+                        // boundary of the view area to the left, which is
+                        // cast from the next column.
+                        //
+                        // If this is the first block in the column, the slope
+                        // of the top-left corner will be greater than the
+                        // initial view slope (1.0).  Handle that here.
+
+                        if (leftBlockSlope <= leftViewSlope) {
+                            assert(sp < stack + viewCeiling);
+                            sp->column     = currentCol;
+                            sp->row        = yc - 1;
+                            sp->leftSlope  = leftViewSlope;
+                            sp->rightSlope = rightViewSlope;
+                            sp->wallSlope  = rightBlockSlope;
+                            ++sp;
+
+                            rightViewSlope = leftBlockSlope;
+                            break;
+                        }
+
+                        // Keep searching to the right (down the column),
+                        // looking for another opening.
+                        prevWasBlocked = 1;
+                        savedRightSlope = rightBlockSlope;
+                    }
                 }
             }
+
+            // If we reach the bottom of the column without finding an open
+            // cell, then the area defined by our view area is completely
+            // obstructed, and we can stop working.
+            if (prevWasBlocked)
+                break;
         }
 
-        // Open areas are handled recursively, with the function continuing to
-        // search to the right (down the column).  If we reach the bottom of
-        // the column without finding an open cell, then the area defined by
-        // our view area is completely obstructed, and we can stop working.
-        if (prevWasBlocked)
+        if (sp == stack)
             break;
+
+        // Resume the scan below the last wall which split the view area.
+        --sp;
+        currentCol      = sp->column;
+        yc              = sp->row;
+        leftViewSlope   = sp->leftSlope;
+        rightViewSlope  = sp->rightSlope;
+        savedRightSlope = sp->wallSlope;
+        prevWasBlocked  = 1;
+        resume          = 1;
+    }
+
+    if (stack != local)
+        free(stack);
+}
+
+/*
+    Casts light into a single octant from the initial view edges.
+*/
+static void gsc_castOctant(GscCast* cc, int octant)
+{
+    cc->txfrm = &s_octantTransform[octant];
+    cc->octant = octant;
+    gsc_castLight(cc, 1, 1.0f, 0.0f);
+}
+
+/*
+    Lights up cells in the selected octants.  The viewer's cell is not lit.
+
+    Octants only test and light cells inside their own triangle, so each can
+    be cast as a separate task on a worker thread.  Cells on the octant edges
+    are shared by two octants and lit with the same distance by both, so
+    GSC_SET_LIGHT must be safe to call from two threads for the same cell.
+
+    \param grid         The cell grid definition.
+    \param gridPos      The player's X,Y position within the grid.
+    \param viewRadius   Maximum view distance; can be a fractional value.
+    \param slopes       Table made by gsc_slopeTableInit() for viewRadius
+                        (or greater) or NULL.
+    \param octantMask   Bit mask of octants to cast (0xff for all).
+*/
+static void gsc_computeOctants(GSC_TYPE* grid, const int* gridPos,
+                               float viewRadius, const GscSlopeTable* slopes,
+                               int octantMask)
+{
+    GscCast cc;
+    int txidx;
+
+    // The left/right inverse slope values are initially 1 and 0, indicating a
+    // diagonal and a horizontal line.  These aren't strictly correct, as the
+    // view area is supposed to be based on corners, not center points.  We
+    // only really care about one side of the wall at the edges of the octant
+    // though.
+
+    // NOTE: depending on the compiler, it's possible that passing the octant
+    // transform values as four integers rather than an object reference would
+    // speed things up. It's much tidier this way though.
+
+    cc.grid = grid;
+    cc.gridPos = gridPos;
+    cc.slopes = NULL;
+    cc.view = NULL;
+    cc.accum = NULL;
+    cc.viewRadius = viewRadius;
+    if (slopes) {
+        assert(slopes->ceiling >= (int) ceilf(viewRadius));
+        cc.slopes = slopes->slope;
+    }
+
+    for (txidx = 0; txidx < 8; txidx++) {
+        if (octantMask & (1 << txidx))
+            gsc_castOctant(&cc, txidx);
     }
 }
 
+/*
+    Lights up cells visible from the current position.  Clear all lighting
+    before calling.
+
+    \param grid         The cell grid definition.
+    \param gridPos      The player's X,Y position within the grid.
+    \param viewRadius   Maximum view distance; can be a fractional value.
+    \param slopes       Table made by gsc_slopeTableInit() for viewRadius
+                        (or greater) or NULL.
+*/
+static void gsc_computeVisibilityS(GSC_TYPE* grid, const int* gridPos,
+                                   float viewRadius,
+                                   const GscSlopeTable* slopes)
+{
+    assert(gridPos[0] >= 0 && gridPos[0] < GSC_XDIM(grid));
+    assert(gridPos[1] >= 0 && gridPos[1] < GSC_YDIM(grid));
+
+    // Viewer's cell is always visible.
+    GSC_SET_LIGHT(grid, gridPos[0], gridPos[1], 0.0f);
+
+    // Cast light into cells for each of 8 octants.
+    gsc_computeOctants(grid, gridPos, viewRadius, slopes, 0xff);
+}
+
 /*
     Lights up cells visible from the current position.  Clear all lighting
     before calling.
@@ -261,34 +581,373 @@ static void gsc_castLight(GSC_TYPE* grid, const int* gridPos, float viewRadius,
 static void gsc_computeVisibility(GSC_TYPE* grid, const int* gridPos,
                                   float viewRadius)
 {
+    gsc_computeVisibilityS(grid, gridPos, viewRadius, NULL);
+}
+
+/*
+    Lights up cells visible from the current position using the view radius
+    and precomputed slopes of a GscSlopeTable.  Clear all lighting before
+    calling.
+
+    \param grid         The cell grid definition.
+    \param gridPos      The player's X,Y position within the grid.
+    \param slopes       Table made by gsc_slopeTableInit().
+*/
+static void gsc_computeVisibilityT(GSC_TYPE* grid, const int* gridPos,
+                                   const GscSlopeTable* slopes)
+{
+    gsc_computeVisibilityS(grid, gridPos, slopes->viewRadius, slopes);
+}
+
+/*
+    Add the light from a number of point lights into a light grid.  Only the
+    cells inside the GscLightGrid rectangle are changed and lights which
+    cannot reach it are skipped, so a small grid can be used to update just
+    a dirty region of the map.
+
+    The light grid is not cleared.  See gsc_castLightsMT() to spread the
+    lights across threads.
+
+    \param grid         The cell grid definition.
+    \param lg           Light accumulation buffer.
+    \param lights       Array of lights.
+    \param count        Number of lights.
+    \param slopes       Table made by gsc_slopeTableInit() for the largest
+                        light radius (or greater) or NULL.
+
+    \return Number of lights cast.
+*/
+static int gsc_castLights(GSC_TYPE* grid, GscLightGrid* lg,
+                          const GscLight* lights, int count,
+                          const GscSlopeTable* slopes)
+{
+    const GscLight* end = lights + count;
+    GscCast cc;
+    int txidx, reach;
+    int cast = 0;
+    int xDim = GSC_XDIM(grid);
+    int yDim = GSC_YDIM(grid);
+
+    cc.grid = grid;
+    cc.slopes = slopes ? slopes->slope : NULL;
+    cc.view = NULL;
+    cc.accum = lg;
+
+    for (; lights != end; ++lights) {
+        const int* pos = lights->pos;
+        if (pos[0] < 0 || pos[0] >= xDim || pos[1] < 0 || pos[1] >= yDim)
+            continue;
+
+        // Cull lights whose bounding square misses the light grid.
+        reach = (int) ceilf(lights->radius);
+        if (pos[0] + reach < lg->x || pos[0] - reach >= lg->x + lg->w ||
+            pos[1] + reach < lg->y || pos[1] - reach >= lg->y + lg->h)
+            continue;
+
+        assert(! slopes || slopes->ceiling >= reach);
+        cc.gridPos = pos;
+        cc.color = lights->color;
+        cc.viewRadius = lights->radius;
+
+        gsc_accumulate(&cc, pos[0], pos[1], 0.0f);
+        for (txidx = 0; txidx < 8; txidx++)
+            gsc_castOctant(&cc, txidx);
+        ++cast;
+    }
+    return cast;
+}
+
+/*
+    Add the light values of one light grid into another.  The src rectangle
+    must be inside the dst rectangle and both must have the same channels.
+*/
+static void gsc_lightGridAdd(GscLightGrid* dst, const GscLightGrid* src)
+{
+    const float* sp = src->light;
+    float* dp;
+    int rowLen = src->w * src->channels;
+    int y, i;
+
+    assert(dst->channels == src->channels);
+    assert(src->x >= dst->x && src->x + src->w <= dst->x + dst->w);
+    assert(src->y >= dst->y && src->y + src->h <= dst->y + dst->h);
+
+    for (y = 0; y < src->h; ++y) {
+        dp = dst->light + ((src->y - dst->y + y) * dst->w + src->x - dst->x) *
+                          dst->channels;
+        for (i = 0; i < rowLen; ++i)
+            dp[i] += sp[i];
+        sp += rowLen;
+    }
+}
+
+#if defined(GSC_THREADS) && ! defined(_WIN32)
+// A slice of the lights cast into a separate light grid by one thread.
+typedef struct {
+    GSC_TYPE* grid;
+    GscLightGrid part;
+    const GscLight* lights;
+    const GscSlopeTable* slopes;
+    int count;
+    int cast;
+    int running;
+    pthread_t thread;
+} GscLightTask;
+
+static void* gsc_lightTaskThread(void* arg)
+{
+    GscLightTask* task = (GscLightTask*) arg;
+    task->cast = gsc_castLights(task->grid, &task->part, task->lights,
+                                task->count, task->slopes);
+    return NULL;
+}
+#endif
+
+/*
+    Same as gsc_castLights() but the lights are split across a number of
+    threads.  Each thread adds its lights into its own zeroed copy of the
+    light grid and these are summed into lg once all are done, so the
+    values may differ from gsc_castLights() by floating point rounding.
+
+    Threads are only used if the module is compiled with GSC_THREADS
+    defined (pthreads is required).  GSC_IS_WALL must be safe to call from
+    multiple threads.
+
+    \param threads      Maximum number of threads to use, including the
+                        calling thread.
+
+    
+eturn Number of lights cast or -1 if memory allocation failed.
+*/
+static int gsc_castLightsMT(GSC_TYPE* grid, GscLightGrid* lg,
+                            const GscLight* lights, int count,
+                            const GscSlopeTable* slopes, int threads)
+{
+#if defined(GSC_THREADS) && ! defined(_WIN32)
+    GscLightTask* tasks;
+    GscLightTask* tp;
+    float* buf;
+    size_t cells = (size_t) lg->w * lg->h * lg->channels;
+    int i, n, slice, cast;
+
+    if (threads > count)
+        threads = count;
+    if (threads < 2)
+        return gsc_castLights(grid, lg, lights, count, slopes);
+
+    // The calling thread casts the first slice directly into lg.
+    --threads;
+    tasks = (GscLightTask*) malloc(threads * sizeof(GscLightTask));
+    buf = (float*) calloc(threads * cells, sizeof(float));
+    if (! tasks || ! buf) {
+        free(tasks);
+        free(buf);
+        return -1;
+    }
+
+    slice = count / (threads + 1);
+    n = count - slice * threads;
+    for (i = 0; i < threads; ++i) {
+        tp = tasks + i;
+        tp->grid   = grid;
+        tp->part   = *lg;
+        tp->part.light = buf + i * cells;
+        tp->lights = lights + n + i * slice;
+        tp->slopes = slopes;
+        tp->count  = slice;
+        tp->running = ! pthread_create(&tp->thread, NULL,
+                                       gsc_lightTaskThread, tp);
+    }
+
+    cast = gsc_castLights(grid, lg, lights, n, slopes);
+
+    for (i = 0; i < threads; ++i) {
+        tp = tasks + i;
+        if (tp->running)
+            pthread_join(tp->thread, NULL);
+        else
+            gsc_lightTaskThread(tp);
+        cast += tp->cast;
+        gsc_lightGridAdd(lg, &tp->part);
+    }
+
+    free(tasks);
+    free(buf);
+    return cast;
+#else
+    (void) threads;
+    return gsc_castLights(grid, lg, lights, count, slopes);
+#endif
+}
+
+#ifdef GSC_CLEAR_LIGHT
+/*
+    Clear the lighting and mask bits of one octant of a view.  Cells on the
+    octant edges which are also lit by another octant are left alone.
+*/
+static void gsc_viewClearOctant(GSC_TYPE* grid, GscView* view, int octant)
+{
+    const OctantTransform* txfrm = &s_octantTransform[octant];
+    uint16_t* mp;
+    uint16_t keep = ~(GSC_TESTED(octant) | GSC_LIT(octant));
+    int xDim = GSC_XDIM(grid);
+    int yDim = GSC_YDIM(grid);
+    int xc, yc, gridX, gridY;
+
+    for (xc = 1; xc <= view->ceiling; xc++) {
+        for (yc = xc; yc >= 0; yc--) {
+            gridX = view->pos[0] + xc * txfrm->xx + yc * txfrm->xy;
+            gridY = view->pos[1] + xc * txfrm->yx + yc * txfrm->yy;
+            if (gridX < 0 || gridX >= xDim || gridY < 0 || gridY >= yDim)
+                continue;
+            mp = &GSC_MASK(view, gridX, gridY);
+            if (*mp & GSC_LIT(octant)) {
+                *mp &= keep;
+                if (! (*mp & 0xff00))
+                    GSC_CLEAR_LIGHT(grid, gridX, gridY);
+            } else
+                *mp &= keep;
+        }
+    }
+}
+
+/*
+    Initialize a cached view.  Use gsc_viewCompute() to light the grid.
+
+    The slopes member is set to NULL and may be assigned a GscSlopeTable
+    made for the same viewRadius.
+
+    \param viewRadius   Maximum view distance; can be a fractional value.
+
+    \return Non-zero if successful or zero if memory allocation failed.
+*/
+static int gsc_viewInit(GscView* view, float viewRadius)
+{
+    int side;
+
+    view->pos[0] = view->pos[1] = -1;
+    view->viewRadius = viewRadius;
+    view->ceiling = (int) ceilf(viewRadius);
+    view->dirty = 0;
+    view->slopes = NULL;
+
+    side = view->ceiling * 2 + 1;
+    view->mask = (uint16_t*) calloc(side * side, sizeof(uint16_t));
+    return view->mask ? 1 : 0;
+}
+
+static void gsc_viewFree(GscView* view)
+{
+    free(view->mask);
+    view->mask = NULL;
+}
+
+static void gsc_viewCast(GSC_TYPE* grid, GscView* view, int octantMask)
+{
+    GscCast cc;
+    int txidx;
+
+    cc.grid = grid;
+    cc.gridPos = view->pos;
+    cc.slopes = NULL;
+    cc.view = view;
+    cc.accum = NULL;
+    cc.viewRadius = view->viewRadius;
+    if (view->slopes) {
+        assert(view->slopes->ceiling >= view->ceiling);
+        cc.slopes = view->slopes->slope;
+    }
+
+    for (txidx = 0; txidx < 8; txidx++) {
+        if (octantMask & (1 << txidx))
+            gsc_castOctant(&cc, txidx);
+    }
+}
+
+/*
+    Light up cells visible from gridPos and record which cells each octant
+    depends on.  If the view was previously computed then any cells it lit
+    are cleared first, so the light grid does not need to be reset by the
+    caller when the viewer moves.
+
+    \param grid         The cell grid definition.
+    \param view         Cached view initialized with gsc_viewInit().
+    \param gridPos      The player's X,Y position within the grid.
+*/
+static void gsc_viewCompute(GSC_TYPE* grid, GscView* view, const int* gridPos)
+{
+    int side = view->ceiling * 2 + 1;
     int txidx;
 
     assert(gridPos[0] >= 0 && gridPos[0] < GSC_XDIM(grid));
     assert(gridPos[1] >= 0 && gridPos[1] < GSC_YDIM(grid));
 
-    // Viewer's cell is always visible.
+    if (view->pos[0] >= 0) {
+        for (txidx = 0; txidx < 8; txidx++)
+            gsc_viewClearOctant(grid, view, txidx);
+        GSC_CLEAR_LIGHT(grid, view->pos[0], view->pos[1]);
+    }
+    memset(view->mask, 0, side * side * sizeof(uint16_t));
+
+    view->pos[0] = gridPos[0];
+    view->pos[1] = gridPos[1];
+    view->dirty = 0;
+
     GSC_SET_LIGHT(grid, gridPos[0], gridPos[1], 0.0f);
+    gsc_viewCast(grid, view, 0xff);
+}
 
-    // Cast light into cells for each of 8 octants.
+/*
+    Notify the view that the wall state of a cell has changed.  Only octants
+    which tested the cell during the last cast are marked as dirty.
 
-    // The left/right inverse slope values are initially 1 and 0, indicating a
-    // diagonal and a horizontal line.  These aren't strictly correct, as the
-    // view area is supposed to be based on corners, not center points.  We
-    // only really care about one side of the wall at the edges of the octant
-    // though.
+    \return Mask of octants made dirty by the change.
+*/
+static int gsc_viewWallChanged(GscView* view, int x, int y)
+{
+    int dx = x - view->pos[0];
+    int dy = y - view->pos[1];
+    int oct;
+
+    if (view->pos[0] < 0 ||
+        dx < -view->ceiling || dx > view->ceiling ||
+        dy < -view->ceiling || dy > view->ceiling)
+        return 0;
+
+    oct = GSC_MASK(view, x, y) & 0xff;
+    view->dirty |= oct;
+    return oct;
+}
 
-    // NOTE: depending on the compiler, it's possible that passing the octant
-    // transform values as four integers rather than an object reference would
-    // speed things up. It's much tidier this way though.
+/*
+    Recast any octants marked dirty by gsc_viewWallChanged().
+
+    \return Number of octants recast.
+*/
+static int gsc_viewUpdate(GSC_TYPE* grid, GscView* view)
+{
+    int txidx;
+    int count = 0;
+
+    if (! view->dirty)
+        return 0;
 
     for (txidx = 0; txidx < 8; txidx++) {
-        gsc_castLight(grid, gridPos, viewRadius, 1, 1.0f, 0.0f,
-                      &s_octantTransform[txidx]);
+        if (view->dirty & (1 << txidx)) {
+            gsc_viewClearOctant(grid, view, txidx);
+            ++count;
+        }
     }
+    gsc_viewCast(grid, view, view->dirty);
+    view->dirty = 0;
+    return count;
 }
+#endif
 
 #undef GSC_TYPE
 #undef GSC_XDIM
 #undef GSC_YDIM
 #undef GSC_IS_WALL
 #undef GSC_SET_LIGHT
+#undef GSC_CLEAR_LIGHT
+#undef GSC_LIGHT_FALLOFF
@@ -42,6 +42,38 @@ void* file_readBinary(const char* path, size_t size)
     return buf;
 }
 
+/*
+ * Read a file in pieces without loading all of it into memory.
+ *
+ * The callback is called with each piece read into buf.  If it returns
+ * non-zero then reading stops.
+ *
+ * \param buf      Buffer for file data.
+ * \param bufSize  Byte size of buf.
+ *
+ * \return Zero if the entire file was read, -1 if the file could not be
+ *         opened or read, or the non-zero value returned by the callback.
+ */
+int file_readChunked(const char* path, void* buf, size_t bufSize,
+                     int (*func)(void* user, const void* data, size_t len),
+                     void* user)
+{
+    size_t n;
+    int status = 0;
+    FILE* fp = fopen(path, "rb");
+    if (! fp)
+        return -1;
+    while ((n = fread(buf, 1, bufSize, fp)) > 0) {
+        status = func(user, buf, n);
+        if (status)
+            break;
+    }
+    if (! status && ferror(fp))
+        status = -1;
+    fclose(fp);
+    return status;
+}
+
 /*
  * Return pointer to filename in path and set stemLen.
  */
@@ -1,7 +1,7 @@
 #ifndef FILE_UTIL_H
 #define FILE_UTIL_H
 /*
- * File Utilities (version 1.1)
+ * File Utilities (version 1.2)
  * Written and dedicated to the public domain in 2023 by Karl Robillard.
  */
 
@@ -11,6 +11,9 @@ extern "C" {
 
 size_t file_size(const char* path);
 void*  file_readBinary(const char* path, size_t size);
+int    file_readChunked(const char* path, void* buf, size_t bufSize,
+                        int (*func)(void* user, const void* data, size_t len),
+                        void* user);
 const char* file_stem(const char* path, size_t* len);
 
 #ifdef __cplusplus
@@ -0,0 +1,95 @@
+#include <stdint.h>
+#include <stdio.h>
+#include "arena.h"
+
+static Arena* frameArena;
+#define CON_MALLOC(size)            arena_alloc(frameArena, size)
+#define CON_REALLOC(ptr, old, size) arena_realloc(frameArena, ptr, old, size)
+#define CON_FREE(ptr)
+
+typedef struct {
+    int* data;
+    size_t used, avail;
+} IntArray;
+
+#include "array.h"
+ARRAY_APPEND(intarr, IntArray, int)
+
+typedef struct {
+    uint32_t* keys;
+    int* vals;
+    uint32_t* hash;
+    uint32_t used, mask;
+} IntMap;
+
+#define HMAP_HASH(key)  ((key) * 2654435761u)
+#include "hashmap.h"
+HMAP_IMPLEMENT(intmap, IntMap, uint32_t, int)
+
+int main(int argc, char** argv)
+{
+    Arena arena;
+    IntArray a, b;
+    IntMap map;
+    int i, created, sum, frame;
+    (void) argc;
+    (void) argv;
+
+    arena_init(&arena, 16 * 1024, 0);
+    frameArena = &arena;
+
+    for (frame = 0; frame < 3; ++frame) {
+        array_initr(a);
+        array_initr(b);
+        hmap_init(&map);
+
+        // Appending to the most recent allocation grows it in place.
+        for (i = 0; i < 100; ++i)
+            *intarr_append(&a, 1) = i;
+        printf("frame %d a: %zu/%zu arena used: %zu\n",
+               frame, a.used, a.avail, arena.used);
+
+        for (i = 0; i < 10; ++i) {
+            *intarr_append(&b, 1) = i * 2;
+            *intarr_append(&a, 1) = i * 3;
+        }
+        for (i = 0; i < 200; ++i)
+            *intmap_insert(&map, i * 5, &created) = i;
+
+        sum = 0;
+        for (i = 0; i < (int) a.used; ++i)
+            sum += a.data[i];
+        for (i = 0; i < (int) b.used; ++i)
+            sum += b.data[i];
+        printf("  sum: %d map: %d find: %d in use: %zu blocks: %d\n",
+               sum, map.used, *intmap_find(&map, 995),
+               arena_inUse(&arena), arena.blockCount);
+
+        arena_reset(&arena);
+    }
+
+    {
+    ArenaMark mark;
+    char* p1;
+    char* p2;
+    void* big;
+
+    p1 = arena_alloc(&arena, 3);
+    mark = arena_mark(&arena);
+    p2 = arena_allocAlign(&arena, 10, 256);
+    printf("align 16: %d align 256: %d\n",
+           (int) ((uintptr_t) p1 & 15), (int) ((uintptr_t) p2 & 255));
+
+    big = arena_alloc(&arena, 40 * 1024);
+    printf("big: %s in use: %zu blocks: %d\n",
+           big ? "ok" : "fail", arena_inUse(&arena), arena.blockCount);
+
+    arena_rollback(&arena, &mark);
+    printf("rollback in use: %zu next: %s\n", arena_inUse(&arena),
+           (arena_alloc(&arena, 3) == p1 + 16) ? "same" : "moved");
+    }
+
+    printf("peak: %zu\n", arena.peak);
+    arena_free(&arena);
+    return 0;
+}
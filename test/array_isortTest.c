@@ -1,5 +1,7 @@
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 
 typedef struct {
     const char* name;
@@ -14,6 +16,34 @@ typedef struct {
 #include "array.h"
 ARRAY_APPEND(items, ItemArray, Item)
 ARRAY_ISORT(items, Item)
+ARRAY_SORT(items, Item)
+ARRAY_ISORT(ints, int)
+ARRAY_SORT(ints, int)
+
+typedef struct {
+    int* data;
+    size_t used, avail;
+} IntArray;
+
+ARRAY_APPEND(intarr, IntArray, int)
+ARRAY_LOWER_BOUND(intarr, IntArray, int)
+ARRAY_BSEARCH(intarr, IntArray, int)
+ARRAY_INSERT_SORTED(intarr, IntArray, int)
+ARRAY_FIND(intarr, IntArray, int)
+
+typedef struct { uint8_t* data; size_t used, avail; } ByteArray;
+typedef struct { uint16_t* data; size_t used, avail; } ShortArray;
+typedef struct { uint64_t* data; size_t used, avail; } LongArray;
+typedef struct { const Item** data; size_t used, avail; } ItemPtrArray;
+
+ARRAY_APPEND(bytearr, ByteArray, uint8_t)
+ARRAY_FIND(bytearr, ByteArray, uint8_t)
+ARRAY_APPEND(shortarr, ShortArray, uint16_t)
+ARRAY_FIND(shortarr, ShortArray, uint16_t)
+ARRAY_APPEND(longarr, LongArray, uint64_t)
+ARRAY_FIND(longarr, LongArray, uint64_t)
+ARRAY_APPEND(ptrarr, ItemPtrArray, const Item*)
+ARRAY_FIND(ptrarr, ItemPtrArray, const Item*)
 
 static const Item testData[7] = {
     { "velcro", 1 },
@@ -35,6 +65,18 @@ int item_less(const Item* a, const Item* b, void* user)
     return strcmp(a->name, b->name) < 0;
 }
 
+int item_lvl_less(const Item* a, const Item* b, void* user)
+{
+    (void) user;
+    return a->lvl < b->lvl;
+}
+
+int int_less(const int* a, const int* b, void* user)
+{
+    (void) user;
+    return *a < *b;
+}
+
 void print_all(const ItemArray* arr)
 {
     for (size_t i = 0; i < arr->used; ++i)
@@ -42,20 +84,144 @@ void print_all(const ItemArray* arr)
     printf("\n");
 }
 
+static double elapsed(clock_t start)
+{
+    return (double) (clock() - start) / CLOCKS_PER_SEC;
+}
+
+/*
+  Sort random integers with _sort and check the order.  If bench is set then
+  the time taken by _sort & _isort is printed.
+*/
+void sort_ints(size_t count, int bench)
+{
+    int* data = (int*) malloc(sizeof(int) * count);
+    int* copy = (int*) malloc(sizeof(int) * count);
+    clock_t start;
+    size_t i, bad = 0;
+
+    srand(count);
+    for (i = 0; i < count; ++i)
+        data[i] = rand() % 10000;
+    memcpy(copy, data, sizeof(int) * count);
+
+    start = clock();
+    ints_sort(data, data + count, int_less, NULL);
+    if (bench)
+        printf("%8zu sort: %.4f", count, elapsed(start));
+
+    for (i = 1; i < count; ++i) {
+        if (data[i] < data[i-1])
+            ++bad;
+    }
+
+    if (bench) {
+        if (count <= 100000) {
+            start = clock();
+            ints_isort(copy, copy + count, int_less, NULL);
+            printf(" isort: %.4f", elapsed(start));
+        }
+        printf("\n");
+    } else
+        printf("sort %zu unordered: %zu\n", count, bad);
+
+    free(data);
+    free(copy);
+}
+
+void sorted_set()
+{
+    static const int keys[10] = { 42, 7, 19, 7, 88, 3, 42, 61, 19, 0 };
+    IntArray set;
+    size_t i;
+    int key;
+
+    array_initr(set);
+    for (i = 0; i < 10; ++i)
+        intarr_insertSorted(&set, keys + i, 1, int_less, NULL);
+
+    printf("sorted set:");
+    for (i = 0; i < set.used; ++i)
+        printf(" %d", set.data[i]);
+    printf("\n");
+
+    for (key = 0; key < 100; key += 19) {
+        printf("find %d: %d %d lower: %zu\n", key,
+               intarr_bsearch(&set, &key, int_less, NULL),
+               intarr_find(&set, key),
+               intarr_lowerBound(&set, &key, int_less, NULL));
+    }
+
+    key = 7;
+    intarr_insertSorted(&set, &key, 0, int_less, NULL);
+    printf("duplicate at: %zu used: %zu\n",
+           intarr_lowerBound(&set, &key, int_less, NULL), set.used);
+
+    array_freer(set);
+}
+
+/*
+  Fill arrays of 8, 16, 64-bit & pointer elements which are longer than a
+  SIMD vector and check that _find returns the position of every element
+  and -1 for a missing value.
+*/
+#define FIND_ERRORS(PRE, AT, ET, VAL, MISSING) \
+static int PRE ## _findErrors(size_t count) { \
+    AT arr; \
+    ET* it; \
+    size_t i; \
+    int bad = 0; \
+    array_initr(arr); \
+    it = PRE ## _append(&arr, count); \
+    for (i = 0; i < count; ++i) \
+        it[i] = VAL(i); \
+    for (i = 0; i < count; ++i) { \
+        if (PRE ## _find(&arr, VAL(i)) != (int) i) \
+            ++bad; \
+    } \
+    if (PRE ## _find(&arr, MISSING) != -1) \
+        ++bad; \
+    array_freer(arr); \
+    return bad; \
+}
+
+#define BYTE_VAL(i)     (uint8_t) (i * 7 + 1)
+#define SHORT_VAL(i)    (uint16_t) (i * 0x101 + 1)
+#define LONG_VAL(i)     ((uint64_t) (i + 1) << 40 | i)
+#define PTR_VAL(i)      (ptrItems + i)
+
+static const Item ptrItems[64];
+
+FIND_ERRORS(bytearr, ByteArray, uint8_t, BYTE_VAL, 0)
+FIND_ERRORS(shortarr, ShortArray, uint16_t, SHORT_VAL, 0)
+FIND_ERRORS(longarr, LongArray, uint64_t, LONG_VAL, 5)
+FIND_ERRORS(ptrarr, ItemPtrArray, const Item*, PTR_VAL, NULL)
+
+void find_sizes()
+{
+    printf("find errors u8: %d u16: %d u64: %d ptr: %d\n",
+           bytearr_findErrors(37), shortarr_findErrors(71),
+           longarr_findErrors(101), ptrarr_findErrors(45));
+}
+
 int main(int argc, char** argv)
 {
     ItemArray arr;
     const int tcount = sizeof(testData) / sizeof(Item);
     size_t i;
-    (void) argc;
-    (void) argv;
+
+    if (argc > 1 && strcmp(argv[1], "-b") == 0) {
+        for (i = 10; i <= 1000000; i *= 10)
+            sort_ints(i, 1);
+        return 0;
+    }
 
     array_initr(arr);
     items_append(&arr, tcount);
     for (i = 0; i < tcount; ++i)
         arr.data[i] = testData[i];
 
-    printf("used: %ld", arr.used);
+    printf("used: %zu", arr.used);
     printf(" first: (%d %s)", arr.data[0].lvl, arr.data[0].name);
     i = arr.used - 1;
     printf(" last: (%d %s)\n", arr.data[i].lvl, arr.data[i].name);
@@ -76,6 +242,18 @@ int main(int argc, char** argv)
     items_isort(arr.data, arr.data + arr.used, item_less, NULL);
     print_all(&arr);
 
+    printf("stable sort by lvl\n");
+    arr.used = tcount;
+    for (i = 0; i < tcount; ++i)
+        arr.data[i] = testData[i];
+    items_sort(arr.data, arr.data + arr.used, item_lvl_less, NULL);
+    print_all(&arr);
+
+    sort_ints(1000, 0);
+    sort_ints(100000, 0);
+    sorted_set();
+    find_sizes();
+
     array_freer(arr);
     return 0;
 }
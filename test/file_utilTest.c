@@ -2,6 +2,20 @@
 #include <string.h>
 
 #include "file_util.c"
+#include "murmurHash3.c"
+
+typedef struct {
+    MurmurHash3State hash;
+    int chunks;
+} ChunkHash;
+
+int hash_chunk(void* user, const void* data, size_t len)
+{
+    ChunkHash* ch = (ChunkHash*) user;
+    murmurHash3_update(&ch->hash, (const uint8_t*) data, len);
+    ch->chunks++;
+    return 0;
+}
 
 int main(int argc, char** argv)
 {
@@ -13,17 +27,42 @@ int main(int argc, char** argv)
         "/path/to/base.ext",
         "C:\\path\\to\\base.ext"
     };
+    const char* hashFile = "file_util.tmp";
     char buf[40];
     const char* base;
     size_t len;
+    ChunkHash ch;
+    FILE* fp;
+    int i;
+    void* whole;
     (void) argc;
     (void) argv;
 
-    for (int i = 0; i < 6; ++i) {
+    for (i = 0; i < 6; ++i) {
         base = file_stem(paths[i], &len);
         memcpy(buf, base, len);
         buf[len] = '\0';
         printf("file_stem \"%s\" -> \"%s\"\n", paths[i], buf);
     }
+
+    // Write a 50 byte file of our own to hash.
+    fp = fopen(hashFile, "wb");
+    if (! fp)
+        return 1;
+    for (i = 0; i < 50; ++i)
+        fputc(i * 37 + 11, fp);
+    fclose(fp);
+
+    // Hash a file in 7 byte pieces and compare with a one-shot hash.
+    len = file_size(hashFile);
+    whole = file_readBinary(hashFile, len);
+    murmurHash3_init(&ch.hash, 0);
+    ch.chunks = 0;
+    i = file_readChunked(hashFile, buf, 7, hash_chunk, &ch);
+    printf("file_readChunked %d (%d chunks) hash match: %d\n", i, ch.chunks,
+           murmurHash3_final(&ch.hash) ==
+           murmurHash3_32((const uint8_t*) whole, len, 0));
+    free(whole);
+    remove(hashFile);
     return 0;
 }
@@ -0,0 +1,278 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+    int nextFree;
+    int value;          // Zero when free.
+    uint32_t gen;
+} Item;
+
+typedef struct {
+    Item* data;
+    size_t used, avail;
+    int firstFree;
+} FixedPool;
+
+typedef struct {
+    Item* data;
+    size_t used, avail;
+    int firstFree;
+    int* live;
+    uint32_t liveCount;
+} ItemPool;
+
+typedef struct {
+    Item** blocks;
+    size_t used, avail;
+    int firstFree;
+} ItemChunkedPool;
+
+#define FPOOL_BLOCK_SHIFT   4
+#define FPOOL_GEN   gen
+#include "fpool.h"
+#define FPOOL_NEXT  nextFree
+#define FPOOL_SET_FREE(it)  ((it)->value = 0)
+#define FPOOL_IS_FREE(it)   ((it)->value == 0)
+FPOOL_IMPLEMENT(fitems, FixedPool, Item)
+FPOOL_DENSE_IMPLEMENT(items, ItemPool, Item)
+FPOOL_HANDLE_IMPLEMENT(items, ItemPool, Item)
+FPOOL_CHUNKED_IMPLEMENT(citems, ItemChunkedPool, Item)
+
+typedef struct {
+    _Atomic int nextFree;
+    int value;
+} AtomicItem;
+
+typedef struct {
+    AtomicItem* data;
+    size_t avail;
+    _Atomic uint64_t freeHead;
+} AtomicPool;
+
+FPOOL_ATOMIC_IMPLEMENT(aitems, AtomicPool, AtomicItem)
+
+void fixed_pool()
+{
+    FixedPool pool;
+    Item* it[8];
+    int i;
+
+    fitems_init(&pool, 6);
+    for (i = 0; i < 8; ++i) {
+        it[i] = fitems_addItem(&pool);
+        if (it[i])
+            it[i]->value = i + 1;
+    }
+    printf("fixed used: %zu full: %s\n", pool.used,
+           it[6] == NULL ? "yes" : "no");
+
+    fitems_removeItem(&pool, it[5]);
+    fitems_removeItem(&pool, it[2]);
+    printf("fixed used: %zu first free: %d\n", pool.used, pool.firstFree);
+    fitems_free(&pool);
+}
+
+void print_live(const ItemPool* pool)
+{
+    uint32_t i;
+    printf("live %d/%zu:", pool->liveCount, pool->used);
+    for (i = 0; i < pool->liveCount; ++i)
+        printf(" %d", fpool_liveItem(pool, i)->value);
+    printf("\n");
+}
+
+void dense_pool()
+{
+    ItemPool pool;
+    Item* it[12];
+    int remap[12];
+    int i, moved;
+
+    items_init(&pool, 12);
+    for (i = 0; i < 12; ++i) {
+        it[i] = items_addItem(&pool);
+        it[i]->value = i + 1;
+    }
+    for (i = 1; i < 11; i += 3)
+        items_removeItem(&pool, it[i]);
+    items_removeItem(&pool, it[0]);
+    print_live(&pool);
+
+    moved = items_defragment(&pool, remap);
+    printf("defragment moved: %d remap:", moved);
+    for (i = 0; i < 12; ++i)
+        printf(" %d", remap[i]);
+    printf("\n");
+    print_live(&pool);
+
+    it[0] = items_addItem(&pool);
+    it[0]->value = 99;
+    printf("add id: %td\n", it[0] - pool.data);
+    print_live(&pool);
+    items_free(&pool);
+}
+
+void handle_pool()
+{
+    ItemPool pool;
+    Item* it;
+    uint32_t ha, hb, hc, hd;
+    int remap[3];
+
+    items_init(&pool, 4);
+    it = items_addItem(&pool);
+    it->value = 1;
+    ha = items_handle(&pool, it);
+    it = items_addItem(&pool);
+    it->value = 2;
+    hb = items_handle(&pool, it);
+
+    items_removeHandle(&pool, ha);
+    items_removeHandle(&pool, ha);      // Ignored.
+    it = items_addItem(&pool);          // Reuses slot of ha.
+    it->value = 3;
+    hc = items_handle(&pool, it);
+
+    printf("handles: %x %x %x\n", ha, hb, hc);
+    it = items_resolve(&pool, ha);
+    printf("resolve a: %d", it ? it->value : -1);
+    it = items_resolve(&pool, hb);
+    printf(" b: %d", it ? it->value : -1);
+    it = items_resolve(&pool, hc);
+    printf(" c: %d", it ? it->value : -1);
+    it = items_resolve(&pool, FPOOL_NULL_HANDLE);
+    printf(" null: %d\n", it ? it->value : -1);
+
+    // Release b and move d into its slot; the stale handle must not
+    // resolve to d.
+    it = items_addItem(&pool);
+    it->value = 4;
+    hd = items_handle(&pool, it);
+    items_removeHandle(&pool, hb);
+    items_defragment(&pool, remap);
+    printf("defragment remap: %d %d %d\n", remap[0], remap[1], remap[2]);
+    it = items_resolve(&pool, hb);
+    printf("resolve b: %d", it ? it->value : -1);
+    it = items_resolve(&pool, hd);
+    printf(" d: %d", it ? it->value : -1);
+    hd = items_handle(&pool, pool.data + remap[2]);
+    it = items_resolve(&pool, hd);
+    printf(" d remapped: %d\n", it ? it->value : -1);
+    items_free(&pool);
+}
+
+void chunked_pool()
+{
+    ItemChunkedPool pool;
+    Item* first;
+    Item* it;
+    int i, id, sum;
+
+    citems_init(&pool, 0);
+    first = citems_addItem(&pool, &id);
+    first->value = 100;
+    for (i = 1; i < 40; ++i) {
+        it = citems_addItem(&pool, &id);
+        it->value = id + 1;
+    }
+    printf("chunked used: %zu avail: %zu first: %d\n",
+           pool.used, pool.avail, first->value);
+
+    citems_removeId(&pool, 39);
+    citems_removeItem(&pool, fpool_item(&pool, 20));
+    citems_removeId(&pool, 38);
+    printf("chunked used: %zu first free: %d\n", pool.used, pool.firstFree);
+
+    // Removed slots are reused before the pool grows.
+    for (i = 0; i < 3; ++i) {
+        it = citems_addItem(&pool, &id);
+        it->value = id + 1;
+        printf(" %d", id);
+    }
+    sum = 0;
+    for (i = 1; i < (int) pool.used; ++i)
+        sum += fpool_item(&pool, i)->value;
+    printf("\nchunked sum: %d item 0 moved: %s\n", sum,
+           fpool_item(&pool, 0) == first ? "no" : "yes");
+
+    // An item whose next field was reused is still found by removeItem.
+    it = fpool_item(&pool, 5);
+    it->nextFree = 33;
+    citems_removeItem(&pool, it);
+    printf("overwritten next removed: %d first free: %d item 33: %d\n",
+           it->value, pool.firstFree, fpool_item(&pool, 33)->value);
+
+    citems_clear(&pool);
+    it = citems_addItem(&pool, &id);
+    printf("clear used: %zu id: %d\n", pool.used, id);
+    citems_free(&pool);
+}
+
+#define THREADS     4
+#define LOOPS       20000
+
+static AtomicPool apool;
+
+void* atomic_worker(void* arg)
+{
+    FPoolCache cache;
+    AtomicItem* held[8];
+    int n = (int) (intptr_t) arg;
+    int i, j, errors = 0;
+
+    fpool_cacheInit(&cache);
+    for (i = 0; i < LOOPS; ++i) {
+        for (j = 0; j < 8; ++j) {
+            held[j] = (j & 1) ? aitems_addItemCached(&apool, &cache)
+                              : aitems_addItem(&apool);
+            if (held[j]->value)
+                ++errors;           // Item given to two threads.
+            held[j]->value = n;
+        }
+        for (j = 0; j < 8; ++j) {
+            if (held[j]->value != n)
+                ++errors;
+            if (j & 1)
+                aitems_removeItemCached(&apool, &cache, held[j]);
+            else
+                aitems_removeItem(&apool, held[j]);
+        }
+    }
+    aitems_flushCache(&apool, &cache);
+    return (void*) (intptr_t) errors;
+}
+
+void atomic_pool()
+{
+    pthread_t thr[THREADS];
+    void* res;
+    int i, errors = 0, count = 0;
+
+    // Room for each thread to hold 8 items and fill its cache.
+    aitems_init(&apool, THREADS * (8 + FPOOL_CACHE_SIZE));
+    for (i = 0; i < THREADS; ++i)
+        pthread_create(thr + i, NULL, atomic_worker, (void*) (intptr_t) (i+1));
+    for (i = 0; i < THREADS; ++i) {
+        pthread_join(thr[i], &res);
+        errors += (int) (intptr_t) res;
+    }
+
+    while (aitems_addItem(&apool))
+        ++count;
+    printf("atomic errors: %d free: %d/%zu\n", errors, count, apool.avail);
+    aitems_free(&apool);
+}
+
+int main(int argc, char** argv)
+{
+    (void) argc;
+    (void) argv;
+
+    fixed_pool();
+    dense_pool();
+    handle_pool();
+    chunked_pool();
+    atomic_pool();
+    return 0;
+}
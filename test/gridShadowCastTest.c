@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <string.h>
+
+#define DIM 21
+#define RAND_DIM 64
+
+typedef struct {
+    int width, height;
+    char solid[RAND_DIM * RAND_DIM];
+    float visible[RAND_DIM * RAND_DIM];
+} Grid;
+
+#define NOT_VISIBLE -1.0f
+
+#define GSC_TYPE                Grid
+#define GSC_XDIM(g)             g->width
+#define GSC_YDIM(g)             g->height
+#define GSC_IS_WALL(g,x,y)      (g->solid[g->width * y + x] == '#')
+#define GSC_SET_LIGHT(g,x,y,ds) g->visible[g->width * y + x] = ds
+#define GSC_CLEAR_LIGHT(g,x,y)  g->visible[g->width * y + x] = NOT_VISIBLE
+#define GSC_THREADS
+#include "gridShadowCast.c"
+
+static const char* testMap =
+    "....................."
+    "....................."
+    "....#######.#####...."
+    "....#...........#...."
+    "....#...........#...."
+    "....#...........#...."
+    "....#...........#...."
+    "....#.....@.....+...."
+    "....#...........#...."
+    "....#...........#...."
+    "....#...........#...."
+    "....#...........#...."
+    "....#############...."
+    "....................."
+    "....................."
+    "....................."
+    "....................."
+    "....................."
+    "....................."
+    "....................."
+    ".....................";
+
+void print_grid(const Grid* grid)
+{
+    int x, y, i;
+    for (y = 0; y < DIM; ++y) {
+        for (x = 0; x < DIM; ++x) {
+            i = y * DIM + x;
+            putchar(grid->visible[i] < 0.0f ? '-' : grid->solid[i]);
+        }
+        putchar('\n');
+    }
+}
+
+void print_light(const GscLightGrid* lg)
+{
+    int x, y, n;
+    for (y = 0; y < lg->h; ++y) {
+        for (x = 0; x < lg->w; ++x) {
+            n = (int) (lg->light[y * lg->w + x] * 9.0f);
+            putchar(n ? '0' + (n > 9 ? 9 : n) : '-');
+        }
+        putchar('\n');
+    }
+}
+
+void clear_light(Grid* grid)
+{
+    for (int i = 0; i < DIM * DIM; ++i)
+        grid->visible[i] = NOT_VISIBLE;
+}
+
+static uint32_t rngState = 0x2545f491;
+
+static uint32_t rng(uint32_t n)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState % n;
+}
+
+/*
+    Toggle random walls near a moving viewer and compare the incrementally
+    updated view with a full computation after every change.
+*/
+void random_toggles(int count)
+{
+    static Grid grid, full;
+    GscView view;
+    int pos[2];
+    int i, x, y, recast = 0, mismatch = 0;
+    const int size = RAND_DIM * RAND_DIM;
+    const float radius = 9.5f;
+
+    grid.width = grid.height = RAND_DIM;
+    for (i = 0; i < size; ++i) {
+        grid.solid[i] = rng(4) ? '.' : '#';
+        grid.visible[i] = NOT_VISIBLE;
+    }
+    full = grid;
+
+    gsc_viewInit(&view, radius);
+    for (i = 0; i < count; ++i) {
+        if (i % 1000 == 0) {
+            pos[0] = 12 + rng(RAND_DIM - 24);
+            pos[1] = 12 + rng(RAND_DIM - 24);
+            grid.solid[pos[1] * RAND_DIM + pos[0]] = '.';
+            gsc_viewCompute(&grid, &view, pos);
+        }
+
+        x = pos[0] - 11 + rng(23);
+        y = pos[1] - 11 + rng(23);
+        if (x == pos[0] && y == pos[1])
+            continue;
+        grid.solid[y * RAND_DIM + x] ^= '.' ^ '#';
+        gsc_viewWallChanged(&view, x, y);
+        recast += gsc_viewUpdate(&grid, &view);
+
+        memcpy(full.solid, grid.solid, size);
+        for (x = 0; x < size; ++x)
+            full.visible[x] = NOT_VISIBLE;
+        gsc_computeVisibility(&full, pos, radius);
+        if (memcmp(full.visible, grid.visible, size * sizeof(float)))
+            ++mismatch;
+    }
+    gsc_viewFree(&view);
+
+    printf("random toggles: %d mismatch: %d recast: %d of %d octants\n",
+           count, mismatch, recast, count * 8);
+}
+
+static GscLight lights[2] = {
+    {{ 10,  7 }, 6.5f, { 1.0f, 1.0f, 1.0f }},
+    {{ 18,  8 }, 4.5f, { 0.5f, 0.5f, 0.5f }}
+};
+
+static float lightBuf[DIM * DIM];
+static float partBuf[2][4 * 4];
+
+/*
+    Cast a light on an open map and check that every cell in range got the
+    falloff exactly once, including the cells on the octant edges.
+*/
+void open_light()
+{
+    static Grid open;
+    static float buf[DIM * DIM];
+    GscLight light = {{ 10, 10 }, 8.5f, { 1.0f, 1.0f, 1.0f }};
+    GscLightGrid lg;
+    float rs = light.radius * light.radius;
+    float want;
+    int x, y, ds, bad = 0;
+
+    open.width = open.height = DIM;
+    memset(open.solid, '.', DIM * DIM);
+    lg.light = buf;
+    lg.x = lg.y = 0;
+    lg.w = lg.h = DIM;
+    lg.channels = 1;
+    gsc_castLights(&open, &lg, &light, 1, NULL);
+
+    for (y = 0; y < DIM; ++y) {
+        for (x = 0; x < DIM; ++x) {
+            ds = (x - 10) * (x - 10) + (y - 10) * (y - 10);
+            want = (ds <= rs) ? 1.0f - ds / rs : 0.0f;
+            if (fabsf(buf[y * DIM + x] - want) > 1e-6f)
+                ++bad;
+        }
+    }
+    printf("open light bad cells: %d\n", bad);
+}
+
+/*
+    Cast many RGB lights with gsc_castLightsMT() and compare with the
+    serial gsc_castLights().
+*/
+void threaded_lights(const Grid* grid)
+{
+    static GscLight many[40];
+    static float serial[DIM * DIM * 3];
+    static float threaded[DIM * DIM * 3];
+    GscLightGrid a, b;
+    float diff, maxDiff = 0.0f;
+    int i, x, y, n, nt;
+
+    for (i = 0; i < 40; ++i) {
+        do {
+            x = rng(DIM);
+            y = rng(DIM);
+        } while (grid->solid[y * DIM + x] == '#');
+        many[i].pos[0] = x;
+        many[i].pos[1] = y;
+        many[i].radius = 2.5f + rng(6);
+        many[i].color[0] = 0.1f * rng(10);
+        many[i].color[1] = 0.1f * rng(10);
+        many[i].color[2] = 0.1f * rng(10);
+    }
+
+    a.x = a.y = 0;
+    a.w = a.h = DIM;
+    a.channels = 3;
+    b = a;
+    a.light = serial;
+    b.light = threaded;
+    n  = gsc_castLights((Grid*) grid, &a, many, 40, NULL);
+    nt = gsc_castLightsMT((Grid*) grid, &b, many, 40, NULL, 4);
+    for (i = 0; i < DIM * DIM * 3; ++i) {
+        diff = fabsf(serial[i] - threaded[i]);
+        if (diff > maxDiff)
+            maxDiff = diff;
+    }
+    printf("threaded lights cast: %d %d match: %d\n",
+           n, nt, maxDiff < 1e-4f);
+}
+
+int main(int argc, char** argv)
+{
+    Grid grid, full;
+    GscView view;
+    GscSlopeTable slopes;
+    GscLightGrid lit, part, dirty;
+    int viewPos[2] = { 10, 7 };
+    float radius = 9.5f;
+    int i, n;
+    (void) argc;
+    (void) argv;
+
+    grid.width = grid.height = DIM;
+    memcpy(grid.solid, testMap, DIM * DIM);
+    for (i = 0; i < DIM * DIM; ++i) {
+        if (grid.solid[i] == '+')
+            grid.solid[i] = '#';
+    }
+    clear_light(&grid);
+
+    gsc_viewInit(&view, radius);
+    gsc_viewCompute(&grid, &view, viewPos);
+    print_grid(&grid);
+
+    // Open the door.
+    grid.solid[7 * DIM + 16] = '+';
+    n = gsc_viewWallChanged(&view, 16, 7);
+    printf("door dirty: %02x recast: %d\n", n, gsc_viewUpdate(&grid, &view));
+    print_grid(&grid);
+
+    // Changing a cell which is not in view does nothing.
+    grid.solid[19 * DIM + 2] = '#';
+    n = gsc_viewWallChanged(&view, 2, 19);
+    printf("hidden dirty: %02x recast: %d\n", n, gsc_viewUpdate(&grid, &view));
+
+    // Compare with a full computation.
+    full = grid;
+    clear_light(&full);
+    gsc_computeVisibility(&full, viewPos, radius);
+    printf("match: %d\n",
+           memcmp(full.visible, grid.visible, DIM * DIM * sizeof(float)) == 0);
+
+    // Compare with a full computation using a slope table.
+    if (gsc_slopeTableInit(&slopes, radius)) {
+        clear_light(&full);
+        gsc_computeVisibilityT(&full, viewPos, &slopes);
+        printf("table match: %d\n", memcmp(full.visible, grid.visible,
+                                            DIM * DIM * sizeof(float)) == 0);
+        gsc_slopeTableFree(&slopes);
+    }
+
+    gsc_viewFree(&view);
+
+    // Cast two lights into a full intensity grid.
+    lit.light = lightBuf;
+    lit.x = lit.y = 0;
+    lit.w = lit.h = DIM;
+    lit.channels = 1;
+    memset(lightBuf, 0, sizeof(lightBuf));
+    printf("lights cast: %d\n", gsc_castLights(&grid, &lit, lights, 2, NULL));
+    print_light(&lit);
+
+    // Relight a dirty region in two halves and sum them.
+    part.light = partBuf[0];
+    part.x = 15;
+    part.y = 5;
+    part.w = part.h = 4;
+    part.channels = 1;
+    dirty = part;
+    dirty.light = partBuf[1];
+    memset(partBuf, 0, sizeof(partBuf));
+    n  = gsc_castLights(&grid, &part,  lights,     1, NULL);
+    n += gsc_castLights(&grid, &dirty, lights + 1, 1, NULL);
+    gsc_lightGridAdd(&dirty, &part);
+    for (i = 0; i < 16; ++i) {
+        if (dirty.light[i] != lightBuf[(5 + i / 4) * DIM + 15 + i % 4])
+            break;
+    }
+    printf("region cast: %d match: %d\n", n, i == 16);
+
+    random_toggles(10000);
+
+    open_light();
+    threaded_lights(&grid);
+
+    return 0;
+}
@@ -0,0 +1,112 @@
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct {
+    int lvl;
+    const char* name;
+} Item;
+
+typedef struct {
+    int* keys;
+    Item* vals;
+    uint32_t* hash;
+    uint32_t used, mask;
+} ItemMap;
+
+#include "hashmap.h"
+HMAP_IMPLEMENT(items, ItemMap, int, Item)
+
+static const char* names[7] = {
+    "velcro", "sherpa", "apple", "zebra", "launch", "frozen", "brush"
+};
+
+void print_item(const ItemMap* map, int key)
+{
+    Item* it = items_find(map, key);
+    if (it)
+        printf(" %d:(%d %s)", key, it->lvl, it->name);
+    else
+        printf(" %d:-", key);
+}
+
+int main(int argc, char** argv)
+{
+    ItemMap map;
+    Item* it;
+    int i, created, sum;
+    (void) argc;
+    (void) argv;
+
+    hmap_init(&map);
+    printf("empty find:");
+    print_item(&map, 3);
+    printf("\n");
+
+    for (i = 0; i < 7; ++i) {
+        it = items_insert(&map, i * 100, &created);
+        it->lvl = i;
+        it->name = names[i];
+    }
+    it = items_insert(&map, 300, &created);
+    printf("used: %d reinsert created: %d\n", map.used, created);
+
+    printf("find:");
+    for (i = 0; i < 8; ++i)
+        print_item(&map, i * 100);
+    printf("\n");
+
+    printf("remove:");
+    printf(" %d", items_remove(&map, 100));
+    printf(" %d", items_remove(&map, 400));
+    printf(" %d", items_remove(&map, 400));
+    printf(" used: %d\n", map.used);
+    printf("find:");
+    for (i = 0; i < 7; ++i)
+        print_item(&map, i * 100);
+    printf("\n");
+
+    // Grow past the initial size and remove all but the original keys.
+    for (i = 1; i < 1000; ++i) {
+        if (i % 100 == 0)
+            continue;
+        it = items_insert(&map, i, &created);
+        it->lvl = -i;
+        it->name = "";
+    }
+    for (i = 1; i < 1000; ++i) {
+        if (i % 100)
+            items_remove(&map, i);
+    }
+
+    sum = 0;
+    for (i = 0; i < (int) hmap_slots(&map); ++i) {
+        if (map.hash[i])
+            sum += map.vals[i].lvl;
+    }
+    printf("used: %d slots: %d level sum: %d\n", map.used, hmap_slots(&map),
+           sum);
+
+    items_clear(&map);
+    printf("cleared used: %d find:", map.used);
+    print_item(&map, 0);
+    printf("\n");
+
+    hmap_free(&map);
+
+    // Fill a table to its load limit; reinserting a key must not grow it.
+    hmap_init(&map);
+    for (i = 0; i < 12; ++i) {
+        it = items_insert(&map, i, &created);
+        it->lvl = i;
+        it->name = "";
+    }
+    sum = hmap_slots(&map);
+    it = items_insert(&map, 5, &created);
+    printf("full slots: %d reinsert created: %d slots: %d lvl: %d\n",
+           sum, created, hmap_slots(&map), it->lvl);
+    it = items_insert(&map, 12, &created);
+    printf("insert created: %d slots: %d\n", created, hmap_slots(&map));
+
+    hmap_free(&map);
+    return 0;
+}
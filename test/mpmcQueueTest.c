@@ -0,0 +1,110 @@
+#include <pthread.h>
+#include <stdio.h>
+
+typedef struct
+{
+    int producer;
+    int id;
+}
+Job;
+
+#include "mpmcQueue.c"
+MPMCQ_IMP(Job)
+
+#define PRODUCERS   4
+#define CONSUMERS   3
+#define COUNT       50000
+
+static MPMCQueue queue;
+
+typedef struct {
+    long sum;
+    int count;
+    int outOfOrder;     // Jobs from one producer must arrive in order.
+} Tally;
+
+void* producer(void* arg)
+{
+    Job job;
+    int i;
+
+    job.producer = (int) (intptr_t) arg;
+    for (i = 0; i < COUNT; ++i) {
+        job.id = i;
+        mpmcq_push_Job(&queue, &job);
+    }
+    return NULL;
+}
+
+void* consumer(void* arg)
+{
+    Tally* tally = (Tally*) arg;
+    int last[PRODUCERS];
+    Job job;
+    int i;
+
+    for (i = 0; i < PRODUCERS; ++i)
+        last[i] = -1;
+    for (;;) {
+        mpmcq_pop_Job(&queue, &job);
+        if (job.id < 0)
+            break;
+        if (job.id <= last[job.producer])
+            tally->outOfOrder++;
+        last[job.producer] = job.id;
+        tally->sum += job.id;
+        tally->count++;
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    pthread_t thr[PRODUCERS + CONSUMERS];
+    Tally tally[CONSUMERS];
+    Job job;
+    long sum = 0;
+    int i, n, count = 0, outOfOrder = 0;
+    (void) argc;
+    (void) argv;
+
+    mpmcq_init_Job(&queue, 30);
+    printf("capacity: %d\n", mpmcq_capacity(&queue));
+
+    job.producer = 0;
+    for (n = 0; ; ++n) {
+        job.id = n;
+        if (! mpmcq_tryPush_Job(&queue, &job))
+            break;
+    }
+    printf("tryPush: %d", n);
+    for (n = 0; mpmcq_tryPop_Job(&queue, &job); ++n)
+        sum += job.id;
+    printf(" tryPop: %d sum: %ld\n", n, sum);
+
+    memset(tally, 0, sizeof(tally));
+    for (i = 0; i < CONSUMERS; ++i)
+        pthread_create(thr + i, NULL, consumer, tally + i);
+    for (i = 0; i < PRODUCERS; ++i)
+        pthread_create(thr + CONSUMERS + i, NULL, producer,
+                       (void*) (intptr_t) i);
+    for (i = 0; i < PRODUCERS; ++i)
+        pthread_join(thr[CONSUMERS + i], NULL);
+
+    // Tell the consumers to stop.
+    job.id = -1;
+    for (i = 0; i < CONSUMERS; ++i)
+        mpmcq_push_Job(&queue, &job);
+
+    sum = 0;
+    for (i = 0; i < CONSUMERS; ++i) {
+        pthread_join(thr[i], NULL);
+        sum += tally[i].sum;
+        count += tally[i].count;
+        outOfOrder += tally[i].outOfOrder;
+    }
+    printf("received: %d out of order: %d sum: %ld\n", count, outOfOrder, sum);
+
+    mpmcq_free(&queue);
+    return 0;
+}
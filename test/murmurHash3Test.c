@@ -0,0 +1,113 @@
+#include <stdio.h>
+#include <string.h>
+#include "murmurHash3.c"
+
+/*
+  SMHasher verification: hash keys {0}, {0,1}, ... {0..254} with seed
+  256 - length, then hash the concatenated results with seed zero.
+*/
+uint32_t verify_32()
+{
+    uint8_t key[256];
+    uint8_t hashes[256 * 4];
+    uint32_t h;
+    int i;
+
+    for (i = 0; i < 256; ++i) {
+        key[i] = (uint8_t) i;
+        h = murmurHash3_32(key, i, 256 - i);
+        memcpy(hashes + i * 4, &h, 4);     // Assumes little-endian.
+    }
+    return murmurHash3_32(hashes, sizeof(hashes), 0);
+}
+
+uint32_t verify_128()
+{
+    uint8_t key[256];
+    uint8_t hashes[256 * 16];
+    uint64_t h[2];
+    int i;
+
+    for (i = 0; i < 256; ++i) {
+        key[i] = (uint8_t) i;
+        murmurHash3_128(key, i, 256 - i, h);
+        memcpy(hashes + i * 16, h, 16);
+    }
+    murmurHash3_128(hashes, sizeof(hashes), 0, h);
+    return (uint32_t) h[0];
+}
+
+// Check each lane of the multi-key hashes against murmurHash3_32().
+int check_lanes(const uint8_t* buf)
+{
+    const uint8_t* keys[8];
+    int len[8];
+    uint32_t out[8];
+    int base, i, bad = 0;
+
+    for (base = 0; base < 64; ++base) {
+        for (i = 0; i < 8; ++i) {
+            keys[i] = buf + i * 3;
+            len[i] = base + i * 5 % 7;      // Mixed and non-multiple of 4.
+        }
+        murmurHash3_32x4(keys, len, base, out);
+        for (i = 0; i < 4; ++i) {
+            if (out[i] != murmurHash3_32(keys[i], len[i], base))
+                ++bad;
+        }
+        murmurHash3_32x8(keys, len, base, out);
+        for (i = 0; i < 8; ++i) {
+            if (out[i] != murmurHash3_32(keys[i], len[i], base))
+                ++bad;
+        }
+    }
+    return bad;
+}
+
+// Check streaming over split input against the one-shot hash.
+int check_stream(const uint8_t* buf, int len)
+{
+    MurmurHash3State st;
+    uint32_t whole = murmurHash3_32(buf, len, 7);
+    int split, chunk, pos, n, bad = 0;
+
+    for (split = 0; split <= len; ++split) {
+        murmurHash3_init(&st, 7);
+        murmurHash3_update(&st, buf, split);
+        murmurHash3_update(&st, buf + split, len - split);
+        if (murmurHash3_final(&st) != whole)
+            ++bad;
+    }
+    for (chunk = 1; chunk <= 17; ++chunk) {
+        murmurHash3_init(&st, 7);
+        for (pos = 0; pos < len; pos += n) {
+            n = (len - pos < chunk) ? len - pos : chunk;
+            murmurHash3_update(&st, buf + pos, n);
+        }
+        if (murmurHash3_final(&st) != whole)
+            ++bad;
+    }
+    return bad;
+}
+
+int main(int argc, char** argv)
+{
+    uint8_t buf[128];
+    uint32_t h;
+    int i;
+    (void) argc;
+    (void) argv;
+
+    h = verify_32();
+    printf("x86_32 verification: %08x %s\n", h,
+           h == 0xB0F57EE3 ? "ok" : "FAIL");
+    h = verify_128();
+    printf("x64_128 verification: %08x %s\n", h,
+           h == 0x6384BA69 ? "ok" : "FAIL");
+
+    for (i = 0; i < 128; ++i)
+        buf[i] = (uint8_t) (i * 37 + 11);
+    printf("x4/x8 lane mismatches: %d\n", check_lanes(buf));
+    printf("stream mismatches: %d\n", check_stream(buf, 101));
+    return 0;
+}
@@ -15,5 +15,69 @@ exe %array_isortTest [
 
 exe %file_utilTest [
     include_from %../io
+    include_from %../algo
     sources [%file_utilTest.c]
 ]
+
+exe %gridShadowCastTest [
+    include_from %../gfx
+    sources [%gridShadowCastTest.c]
+    libs %m
+    libs %pthread
+]
+
+exe %murmurHash3Test [
+    include_from %../algo
+    sources [%murmurHash3Test.c]
+]
+
+exe %hashmapTest [
+    include_from %../con
+    include_from %../algo
+    sources [%hashmapTest.c %../algo/murmurHash3.c]
+]
+
+exe %quickSortIndexMTTest [
+    include_from %../algo
+    sources [%quickSortIndexMTTest.c]
+    libs %pthread
+]
+
+exe %quickSortIndexTest [
+    include_from %../algo
+    sources [%quickSortIndexTest.c %../algo/quickSortIndex.c]
+]
+
+exe %arenaTest [
+    include_from %../con
+    sources [%arenaTest.c %../con/arena.c]
+]
+
+exe %fpoolTest [
+    include_from %../con
+    sources [%fpoolTest.c]
+    libs %pthread
+]
+
+exe %spscQueueTest [
+    include_from %../con
+    sources [%spscQueueTest.c]
+    libs %pthread
+]
+
+exe %mpmcQueueTest [
+    include_from %../con
+    sources [%mpmcQueueTest.c]
+    libs %pthread
+]
+
+exe %taskPoolTest [
+    include_from %../con
+    sources [%taskPoolTest.c %../con/taskPool.c]
+    libs %pthread
+]
+
+exe %undoTest [
+    include_from %../con
+    sources [%undoTest.c]
+]
@@ -0,0 +1,129 @@
+/*
+  Build quickSortIndex.c with QUICKSORT_THREADS so that quickSortIndexMT()
+  uses its pthread path, and check it against the serial sort.
+*/
+#define QUICKSORT_THREADS
+#include <stdio.h>
+#include <stdlib.h>
+#include "quickSortIndex.c"
+
+static int int_compare(void* user, void* a, void* b)
+{
+    int ia = *((int*) a);
+    int ib = *((int*) b);
+    (void) user;
+    return (ia < ib) ? -1 : (ia > ib) ? 1 : 0;
+}
+
+/*
+  Return non-zero if the MT sort of count values with threads matches the
+  serial sort.  With unique keys the indices must be identical; with
+  duplicates the key order must match and the index must be a permutation.
+*/
+static int compare_sorts(int* data, uint32_t count, int threads)
+{
+    QuickSortIndex qs;
+    uint32_t* serial = (uint32_t*) malloc(count * sizeof(uint32_t));
+    uint32_t* mt     = (uint32_t*) malloc(count * sizeof(uint32_t));
+    uint8_t* seen    = (uint8_t*) calloc(count, 1);
+    uint32_t i;
+    int ok;
+
+    qs.user  = NULL;
+    qs.data  = (uint8_t*) data;
+    qs.elemSize = sizeof(int);
+    qs.compare  = int_compare;
+
+    qs.index = serial;
+    quickSortIndex(&qs, 0, count, 1);
+    qs.index = mt;
+    ok = (quickSortIndexMT(&qs, 0, count, 1, threads) == (int) count);
+
+    for (i = 0; ok && i < count; ++i) {
+        if (mt[i] >= count || seen[mt[i]] ||
+            data[mt[i]] != data[serial[i]])
+            ok = 0;
+        else
+            seen[mt[i]] = 1;
+    }
+
+    free(serial);
+    free(mt);
+    free(seen);
+    return ok;
+}
+
+/*
+  Fill data so the pivot samples of the first partition hold the smallest
+  values, which leaves only a few elements on its left side.
+*/
+static void skewed_data(int* data, uint32_t count)
+{
+    uint32_t l = 0, r = count - 1;
+    uint32_t s = (r - l) / 8;
+    uint32_t p = (l + r) / 2;
+    uint32_t pos[11];
+    uint32_t i;
+
+    pos[0] = l;         pos[1] = l + 1;     pos[2] = l + s;
+    pos[3] = l + s * 2; pos[4] = p - s;     pos[5] = p;
+    pos[6] = p + s;     pos[7] = r - s * 2; pos[8] = r - s;
+    pos[9] = r - 1;     pos[10] = r;
+
+    for (i = 0; i < count; ++i)
+        data[i] = 100 + rand() % 100000;
+    for (i = 0; i < 11; ++i)
+        data[pos[i]] = i;
+}
+
+int main(int argc, char** argv)
+{
+    static const uint32_t sizes[3] = { 1000, 50000, 300000 };
+    static const int threadCounts[3] = { 2, 4, 8 };
+    int* data;
+    uint32_t i, count;
+    int s, t, unique, same;
+    (void) argc;
+    (void) argv;
+
+    for (s = 0; s < 3; ++s) {
+        count = sizes[s];
+        data = (int*) malloc(count * sizeof(int));
+        for (unique = 0; unique < 2; ++unique) {
+            srand(count + unique);
+            if (unique) {
+                // Shuffled permutation of 0..count-1.
+                for (i = 0; i < count; ++i)
+                    data[i] = i;
+                for (i = count - 1; i > 0; --i) {
+                    uint32_t j = rand() % (i + 1);
+                    int tmp = data[i];
+                    data[i] = data[j];
+                    data[j] = tmp;
+                }
+            } else {
+                for (i = 0; i < count; ++i)
+                    data[i] = rand() % 100;
+            }
+
+            same = 0;
+            for (t = 0; t < 3; ++t)
+                same += compare_sorts(data, count, threadCounts[t]);
+            printf("count %6d %s: %d of 3 thread counts match serial\n",
+                   count, unique ? "unique" : "dups  ", same);
+        }
+        free(data);
+    }
+
+    count = sizes[2];
+    data = (int*) malloc(count * sizeof(int));
+    srand(count);
+    skewed_data(data, count);
+    same = 0;
+    for (t = 0; t < 3; ++t)
+        same += compare_sorts(data, count, threadCounts[t]);
+    printf("count %6d skewed: %d of 3 thread counts match serial\n",
+           count, same);
+    free(data);
+    return 0;
+}
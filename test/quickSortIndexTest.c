@@ -0,0 +1,312 @@
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "quickSortIndex.h"
+
+typedef struct {
+    const char* name;
+    int lvl;
+    float weight;
+} Item;
+
+static const Item testData[9] = {
+    { "velcro", 1,  0.5f },
+    { "sherpa", 4, -2.0f },
+    { "apple",  3,  7.25f },
+    { "zebra",  2,  1.0f },
+    { "launch", 2, -0.75f },
+    { "frozen", 1,  3.5f },
+    { "brush",  1,  0.0f },
+    { "quartz", 5,  2.0f },
+    { "mango",  3, -9.5f }
+};
+
+#define ITEM_COUNT  (sizeof(testData) / sizeof(Item))
+
+static int item_compare(void* user, void* a, void* b)
+{
+    const Item* ia = (const Item*) a;
+    const Item* ib = (const Item*) b;
+    (void) user;
+    if (ia->lvl > ib->lvl)
+        return 1;
+    if (ia->lvl < ib->lvl)
+        return -1;
+    return 0;
+}
+
+#define item_less(a,b)  ((a)->weight < (b)->weight)
+QSORT_INDEX_IMP(item, Item, item_less)
+
+static void print_index(const char* label, const uint32_t* index, int count)
+{
+    int i;
+    printf("%s:", label);
+    for (i = 0; i < count; ++i)
+        printf(" %s", testData[index[i]].name);
+    printf("\n");
+}
+
+static int int_compare(void* user, void* a, void* b)
+{
+    int ia = *(const int*) a;
+    int ib = *(const int*) b;
+    (void) user;
+    return (ia > ib) ? 1 : (ia < ib) ? -1 : 0;
+}
+
+#define int_less(a,b)   (*(a) < *(b))
+QSORT_INDEX_IMP(int, int, int_less)
+
+/*
+  Sort a large random set of integers with each method and check the order.
+*/
+static void check_large(uint32_t count)
+{
+    QuickSortIndex qs;
+    int* data = (int*) malloc(count * sizeof(int));
+    uint32_t* index = (uint32_t*) malloc(count * sizeof(uint32_t));
+    uint32_t i;
+    int n, pass, bad;
+
+    srand(7);
+    for (i = 0; i < count; ++i)
+        data[i] = rand() % 1000 - 500;
+
+    qs.index = index;
+    qs.user  = NULL;
+    qs.data  = (uint8_t*) data;
+    qs.elemSize = sizeof(int);
+    qs.compare  = int_compare;
+
+    for (pass = 0; pass < 3; ++pass) {
+        if (pass == 0)
+            n = quickSortIndexMT(&qs, 0, count, 1, 4);
+        else if (pass == 1)
+            n = radixSortIndex(&qs, 0, count, 1, 0, QSORT_KEY_I32);
+        else
+            n = int_sortIndex(index, data, 0, count, 1);
+
+        bad = 0;
+        for (i = 1; i < (uint32_t) n; ++i) {
+            if (data[index[i-1]] > data[index[i]])
+                ++bad;
+        }
+        printf("large %d count: %d unordered: %d\n", pass, n, bad);
+    }
+
+    free(data);
+    free(index);
+}
+
+/*
+  Radix sort unsigned 32 & 64-bit keys which use the high bits and check
+  the order and that equal keys keep their original order.
+*/
+static void check_radix_unsigned(uint32_t count)
+{
+    QuickSortIndex qs;
+    uint32_t* k32 = (uint32_t*) malloc(count * sizeof(uint32_t));
+    uint64_t* k64 = (uint64_t*) malloc(count * sizeof(uint64_t));
+    uint32_t* index = (uint32_t*) malloc(count * sizeof(uint32_t));
+    uint32_t i, a, b;
+    int n, bad;
+
+    srand(11);
+    for (i = 0; i < count; ++i) {
+        k32[i] = ((uint32_t) (rand() % 64) << 26) | (rand() % 4);
+        k64[i] = ((uint64_t) k32[i] << 32) | (rand() % 8);
+    }
+
+    qs.index = index;
+    qs.user  = NULL;
+    qs.compare  = NULL;
+
+    qs.data  = (uint8_t*) k32;
+    qs.elemSize = sizeof(uint32_t);
+    n = radixSortIndex(&qs, 0, count, 1, 0, QSORT_KEY_U32);
+    bad = 0;
+    for (i = 1; i < (uint32_t) n; ++i) {
+        a = index[i-1];
+        b = index[i];
+        if (k32[a] > k32[b] || (k32[a] == k32[b] && a > b))
+            ++bad;
+    }
+    printf("radix u32 count: %d unordered: %d\n", n, bad);
+
+    qs.data  = (uint8_t*) k64;
+    qs.elemSize = sizeof(uint64_t);
+    n = radixSortIndex(&qs, 0, count, 1, 0, QSORT_KEY_U64);
+    bad = 0;
+    for (i = 1; i < (uint32_t) n; ++i) {
+        a = index[i-1];
+        b = index[i];
+        if (k64[a] > k64[b] || (k64[a] == k64[b] && a > b))
+            ++bad;
+    }
+    printf("radix u64 count: %d unordered: %d\n", n, bad);
+
+    free(k32);
+    free(k64);
+    free(index);
+}
+
+static int compareCount;
+
+static int int_compareCount(void* user, void* a, void* b)
+{
+    ++compareCount;
+    return int_compare(user, a, b);
+}
+
+/*
+  McIlroy's antiquicksort adversary.  All values start as "gas" (larger than
+  any solid value) and are frozen to the next solid value only when two gas
+  values are compared, which drives a quicksort to quadratic behavior.
+*/
+typedef struct {
+    int* val;
+    int gas;
+    int nsolid;
+    int candidate;
+} Adversary;
+
+static int adversary_compare(void* user, void* a, void* b)
+{
+    Adversary* adv = (Adversary*) user;
+    int x = (int*) a - adv->val;
+    int y = (int*) b - adv->val;
+    ++compareCount;
+    if (adv->val[x] == adv->gas && adv->val[y] == adv->gas) {
+        if (x == adv->candidate)
+            adv->val[x] = adv->nsolid++;
+        else
+            adv->val[y] = adv->nsolid++;
+    }
+    if (adv->val[x] == adv->gas)
+        adv->candidate = x;
+    else if (adv->val[y] == adv->gas)
+        adv->candidate = y;
+    return int_compare(NULL, adv->val + x, adv->val + y);
+}
+
+/*
+  Sort inputs that defeat a plain median-of-three quicksort and check that
+  the order is correct and the number of comparisons stays O(n log n).
+*/
+static void check_introsort(int count)
+{
+    static const char* names[5] = {
+        "sorted", "reversed", "equal", "med3-killer", "adversary"
+    };
+    QuickSortIndex qs;
+    Adversary adv;
+    int* data = (int*) malloc(count * sizeof(int));
+    uint32_t* index = (uint32_t*) malloc(count * sizeof(uint32_t));
+    int i, n, pass, bad, log2n, k;
+
+    for (log2n = 0; (1 << log2n) < count; ++log2n)
+        ;
+
+    qs.index = index;
+    qs.data  = (uint8_t*) data;
+    qs.elemSize = sizeof(int);
+
+    for (pass = 0; pass < 5; ++pass) {
+        qs.user = NULL;
+        qs.compare = int_compareCount;
+        switch (pass) {
+        case 0:
+            for (i = 0; i < count; ++i)
+                data[i] = i;
+            break;
+        case 1:
+            for (i = 0; i < count; ++i)
+                data[i] = count - i;
+            break;
+        case 2:
+            for (i = 0; i < count; ++i)
+                data[i] = 7;
+            break;
+        case 3:
+            // Musser's median-of-3 killer sequence.
+            k = count / 2;
+            for (i = 1; i <= k; ++i) {
+                if (i & 1) {
+                    data[i - 1] = i;
+                    data[i] = k + i;
+                }
+                data[k + i - 1] = 2 * i;
+            }
+            break;
+        case 4:
+            adv.val = data;
+            adv.gas = count - 1;
+            adv.nsolid = 0;
+            adv.candidate = 0;
+            for (i = 0; i < count; ++i)
+                data[i] = adv.gas;
+            qs.user = (uint8_t*) &adv;
+            qs.compare = adversary_compare;
+            break;
+        }
+
+        compareCount = 0;
+        n = quickSortIndex(&qs, 0, count, 1);
+
+        bad = 0;
+        for (i = 1; i < n; ++i) {
+            if (data[index[i-1]] > data[index[i]])
+                ++bad;
+        }
+        printf("%s count: %d unordered: %d n log n compares: %d\n",
+               names[pass], n, bad, compareCount <= 4 * count * log2n);
+    }
+
+    free(data);
+    free(index);
+}
+
+int main(int argc, char** argv)
+{
+    QuickSortIndex qs;
+    uint32_t index[ITEM_COUNT];
+    int n;
+    (void) argc;
+    (void) argv;
+
+    qs.index = index;
+    qs.user  = NULL;
+    qs.data  = (uint8_t*) testData;
+    qs.elemSize = sizeof(Item);
+    qs.compare  = item_compare;
+
+    n = quickSortIndex(&qs, 0, ITEM_COUNT, 1);
+    printf("quickSortIndex count: %d\n", n);
+    print_index("lvl", index, n);
+
+    n = quickSortIndex(&qs, 1, ITEM_COUNT, 2);
+    print_index("odd", index, n);
+
+    n = radixSortIndex(&qs, 0, ITEM_COUNT, 1, offsetof(Item, lvl),
+                       QSORT_KEY_I32);
+    print_index("radix lvl", index, n);
+
+    n = radixSortIndex(&qs, 0, ITEM_COUNT, 1, offsetof(Item, weight),
+                       QSORT_KEY_FLOAT);
+    print_index("radix weight", index, n);
+
+    n = item_sortIndex(index, testData, 0, ITEM_COUNT, 1);
+    print_index("template weight", index, n);
+
+    n = partialSortIndex(&qs, 0, ITEM_COUNT, 1, 3);
+    print_index("top 3 lvl", index, 3);
+
+    n = nthElementIndex(&qs, 0, ITEM_COUNT, 1, 7);
+    printf("nth 7 lvl: %d\n", testData[index[7]].lvl);
+
+    check_large(100000);
+    check_introsort(50000);
+    check_radix_unsigned(20000);
+    return 0;
+}
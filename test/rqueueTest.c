@@ -9,10 +9,26 @@ MyData;
 #include "rqueue.c"
 RQUEUE_IMP(MyData)
 
+void print_spans(const RQueueSpans* span)
+{
+    const MyData* dat;
+    uint32_t i, s;
+
+    for (s = 0; s < 2; ++s) {
+        dat = (const MyData*) span->ptr[s];
+        printf(" [");
+        for (i = 0; i < span->len[s]; ++i)
+            printf(i ? " %d" : "%d", dat[i].id);
+        printf("]");
+    }
+}
+
 int main(int argc, char** argv)
 {
     RQueue rb;
+    RQueueSpans span;
     MyData* dat;
+    uint32_t i, n;
     int in, out;
     (void) argc;
     (void) argv;
@@ -40,6 +56,19 @@ int main(int argc, char** argv)
         printf(" %d", dat->id);
     printf(" (used: %d)\n", rb.used);
 
+    // Bulk transfers wrap around the end of the buffer in two spans.
+    rqueue_appendN_MyData(&rb, 6, &span);
+    for (i = 0; i < span.len[0]; ++i)
+        ((MyData*) span.ptr[0])[i].id = in++;
+    for (i = 0; i < span.len[1]; ++i)
+        ((MyData*) span.ptr[1])[i].id = in++;
+    printf("appendN avail: %d spans: %d %d\n",
+           rb.avail, span.len[0], span.len[1]);
+    n = rqueue_removeHeadN_MyData(&rb, 10, &span);
+    printf("removeHeadN: %d", n);
+    print_spans(&span);
+    printf(" (used: %d)\n", rb.used);
+
     rqueue_free(&rb);
     return 0;
 }
@@ -0,0 +1,76 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+
+typedef struct
+{
+    int id;
+    int value;
+}
+Event;
+
+#include "spscQueue.c"
+SPSCQ_IMP(Event)
+
+#define COUNT   200000
+
+static SPSCQueue queue;
+
+void* producer(void* arg)
+{
+    Event* ev;
+    int i;
+    (void) arg;
+
+    for (i = 0; i < COUNT; ++i) {
+        while (! (ev = spscq_append_Event(&queue)))
+            sched_yield();
+        ev->id = i;
+        ev->value = i & 7;
+        spscq_commitAppend(&queue);
+    }
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    pthread_t thr;
+    Event* ev;
+    int i, full, outOfOrder = 0;
+    long sum = 0;
+    (void) argc;
+    (void) argv;
+
+    spscq_init(&queue, 100, sizeof(Event));
+    printf("capacity: %d\n", spscq_capacity(&queue));
+
+    // Single thread: fill until full then drain.
+    for (full = 0; (ev = spscq_append_Event(&queue)); ++full) {
+        ev->id = full;
+        spscq_commitAppend(&queue);
+    }
+    printf("filled: %d\n", full);
+    for (i = 0; (ev = spscq_head_Event(&queue)); ++i) {
+        if (ev->id != i)
+            ++outOfOrder;
+        spscq_removeHead(&queue);
+    }
+    printf("drained: %d out of order: %d\n", i, outOfOrder);
+
+    // Two threads.
+    pthread_create(&thr, NULL, producer, NULL);
+    for (i = 0; i < COUNT; ++i) {
+        while (! (ev = spscq_head_Event(&queue)))
+            sched_yield();
+        if (ev->id != i)
+            ++outOfOrder;
+        sum += ev->value;
+        spscq_removeHead(&queue);
+    }
+    pthread_join(thr, NULL);
+    printf("received: %d out of order: %d sum: %ld empty: %s\n",
+           i, outOfOrder, sum, spscq_head_Event(&queue) ? "no" : "yes");
+
+    spscq_free(&queue);
+    return 0;
+}
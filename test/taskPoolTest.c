@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include "taskPool.h"
+
+#define COUNT   100000
+
+static TaskPool pool;
+static int values[COUNT];
+static _Atomic long rangeSum;
+static _Atomic int rangeCalls;
+
+void square_range(void* arg, uint32_t begin, uint32_t end)
+{
+    long sum = 0;
+    uint32_t i;
+    (void) arg;
+
+    for (i = begin; i < end; ++i) {
+        values[i] = i * 2;
+        sum += values[i];
+    }
+    atomic_fetch_add(&rangeSum, sum);
+    atomic_fetch_add(&rangeCalls, 1);
+}
+
+typedef struct {
+    int n;
+    long result;
+} Fib;
+
+// Recursive fork-join with tasks spawned from inside tasks.
+void fib_task(void* arg)
+{
+    Fib* f = (Fib*) arg;
+    if (f->n < 12) {
+        long a = 0, b = 1, t;
+        int i;
+        for (i = 0; i < f->n; ++i) {
+            t = a + b;
+            a = b;
+            b = t;
+        }
+        f->result = a;
+    } else {
+        TaskGroup grp;
+        Fib f1, f2;
+        f1.n = f->n - 1;
+        f2.n = f->n - 2;
+        taskGroup_init(&grp);
+        taskPool_run(&pool, &grp, fib_task, &f1);
+        fib_task(&f2);
+        taskPool_wait(&pool, &grp);
+        f->result = f1.result + f2.result;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Fib fib;
+    long check = 0;
+    int i, threads;
+    (void) argc;
+    (void) argv;
+
+    threads = taskPool_init(&pool, 4);
+    printf("threads: %d\n", threads);
+
+    taskPool_parallelFor(&pool, 0, COUNT, 1000, square_range, NULL);
+    for (i = 0; i < COUNT; ++i)
+        check += values[i];
+    printf("parallelFor sum: %ld check: %ld calls: %d\n",
+           (long) rangeSum, check, (int) rangeCalls);
+
+    // Zero grain picks a size from the thread count.
+    rangeSum = 0;
+    taskPool_parallelFor(&pool, 0, COUNT, 0, square_range, NULL);
+    printf("auto grain sum: %ld\n", (long) rangeSum);
+
+    fib.n = 30;
+    {
+    TaskGroup grp;
+    taskGroup_init(&grp);
+    taskPool_run(&pool, &grp, fib_task, &fib);
+    taskPool_wait(&pool, &grp);
+    }
+    printf("fib(30): %ld\n", fib.result);
+
+    taskPool_free(&pool);
+    return 0;
+}
@@ -52,5 +52,16 @@ stdout  1 t01-rqueue "rqueueTest"
 stdout  2 t02-btree2 "btree2Test"
 stdout  3 t03-array_isort "array_isortTest"
 stdout  4 t04-file_util "file_utilTest"
+stdout  5 t05-gridShadowCast "gridShadowCastTest"
+stdout  6 t06-murmurHash3 "murmurHash3Test"
+stdout  7 t07-hashmap "hashmapTest"
+stdout  8 t08-quickSortIndexMT "quickSortIndexMTTest"
+stdout  9 t09-quickSortIndex "quickSortIndexTest"
+stdout 10 t10-arena "arenaTest"
+stdout 11 t11-fpool "fpoolTest"
+stdout 12 t12-spscQueue "spscQueueTest"
+stdout 13 t13-mpmcQueue "mpmcQueueTest"
+stdout 14 t14-taskPool "taskPoolTest"
+stdout 15 t15-undo "undoTest"
 
 report
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include "undo.c"
+
+void record_steps(UndoStack* us, int first, int count, int values)
+{
+    UndoValue data[40];
+    int i, j;
+
+    for (i = first; i < first + count; ++i) {
+        for (j = 0; j < values; ++j)
+            data[j].i = i * 100 + j;
+        undo_record(us, i, data, values);
+    }
+}
+
+// Print opcodes of steps behind & ahead of the position, checking values.
+void print_history(UndoStack* us, const char* label)
+{
+    const UndoValue* st;
+    int back = 0, ahead = 0, bad = 0, i;
+
+    printf("%s:", label);
+    while (undo_stepBack(us, &st) != Undo_AtEnd)
+        ++back;
+    while (undo_stepForward(us, &st) != Undo_AtEnd) {
+        for (i = 1; i < st->op.skipNext; ++i) {
+            if (st[i].i != st->op.code * 100 + i - 1)
+                ++bad;
+        }
+        printf(" %d", st->op.code);
+        ++ahead;
+    }
+    for (i = 0; i < ahead - back; ++i)
+        undo_stepBack(us, &st);
+    printf(" (undo %d, redo %d, bad %d, wrap %s)\n", back, ahead - back,
+           bad, us->wrap ? "yes" : "no");
+}
+
+/*
+  Compare the stack against a reference model over random records, steps,
+  and clears.  The model keeps every recorded step; the stack must hold
+  the newest of those before the position (the oldest may be discarded)
+  and all of those after it.
+*/
+#define MODEL_STEPS     40000
+#define MODEL_VALUES    40
+
+typedef struct {
+    int values[MODEL_STEPS];    // Value count of each recorded step.
+    int end;                    // Number of steps recorded.
+    int first;                  // Oldest step still held by the stack.
+    int pos;
+    int errors;
+    int maxHeld;                // Most values held at once.
+} UndoModel;
+
+static int model_code(int n) { return n % 60000 + 1; }
+
+static int model_checkStep(UndoModel* m, const UndoValue* st, int n)
+{
+    int i;
+    if (st->op.code != model_code(n) ||
+        st->op.skipNext != m->values[n] + 1)
+        return 1;
+    for (i = 0; i < m->values[n]; ++i) {
+        if (st[i + 1].i != n * 1000 + i)
+            return 1;
+    }
+    return 0;
+}
+
+// Walk the whole history, check it, and update m->first.
+static void model_verify(UndoModel* m, UndoStack* us, int limitValues)
+{
+    const UndoValue* st;
+    int back = 0, ahead = 0, held = 1, i;
+
+    while (undo_stepBack(us, &st) != Undo_AtEnd) {
+        ++back;
+        if (m->pos - back < 0 || model_checkStep(m, st, m->pos - back)) {
+            ++m->errors;
+            return;
+        }
+        held += st->op.skipNext;
+    }
+    while (undo_stepForward(us, &st) != Undo_AtEnd) {
+        if (ahead >= back && m->pos + ahead - back < m->end) {
+            if (model_checkStep(m, st, m->pos + ahead - back))
+                ++m->errors;
+            held += st->op.skipNext;
+        }
+        ++ahead;
+    }
+    for (i = 0; i < ahead - back; ++i)
+        undo_stepBack(us, &st);
+
+    if (ahead - back != m->end - m->pos || m->pos - back < m->first ||
+        (limitValues && held > limitValues))
+        ++m->errors;
+    m->first = m->pos - back;
+    if (held > m->maxHeld)
+        m->maxHeld = held;
+}
+
+static void model_test(uint32_t byteLimit, int maxValues, int ops)
+{
+    UndoStack us;
+    UndoModel* m = (UndoModel*) calloc(1, sizeof(UndoModel));
+    UndoValue data[256];
+    const UndoValue* st;
+    int i, j, n, r, adv, expect;
+    int wraps = 0, grows = 0, discards = 0;
+    uint32_t avail;
+    int oversize = (maxValues + 1) * (int) UV_SIZE > (int) byteLimit;
+
+    undo_init(&us, byteLimit);
+    avail = us.avail;
+    srand(byteLimit);
+    for (i = 0; i < ops && m->end < MODEL_STEPS; ++i) {
+        r = rand() % 2000;
+        if (r < 1000) {
+            n = m->end = m->pos;
+            m->values[n] = rand() % (maxValues + 1);
+            for (j = 0; j < m->values[n]; ++j)
+                data[j].i = n * 1000 + j;
+            undo_record(&us, model_code(n), data, m->values[n]);
+            m->pos = ++m->end;
+            j = m->first;
+            model_verify(m, &us, oversize ? 0 : byteLimit / UV_SIZE);
+            if (m->first > j)
+                ++discards;
+            if (us.wrap)
+                ++wraps;
+            if (us.avail != avail) {
+                avail = us.avail;
+                ++grows;
+            }
+        } else if (r < 1500) {
+            adv = undo_stepBack(&us, &st);
+            if (m->pos == m->first) {
+                if (adv != Undo_AtEnd || st)
+                    ++m->errors;
+            } else {
+                expect = Undo_Advanced;
+                if (m->pos == m->end)
+                    expect |= Undo_AdvancedFromStart;
+                --m->pos;
+                if (m->pos == m->first)
+                    expect |= Undo_AdvancedToEnd;
+                if (adv != expect || model_checkStep(m, st, m->pos))
+                    ++m->errors;
+            }
+        } else if (r < 1999) {
+            adv = undo_stepForward(&us, &st);
+            if (m->pos == m->end) {
+                if (adv != Undo_AtEnd || st)
+                    ++m->errors;
+            } else {
+                expect = Undo_Advanced;
+                if (m->pos == m->first)
+                    expect |= Undo_AdvancedFromStart;
+                if (model_checkStep(m, st, m->pos))
+                    ++m->errors;
+                ++m->pos;
+                if (m->pos == m->end)
+                    expect |= Undo_AdvancedToEnd;
+                if (adv != expect)
+                    ++m->errors;
+            }
+        } else {
+            undo_clear(&us);
+            m->first = m->pos = m->end;
+        }
+    }
+    model_verify(m, &us, 0);
+
+    printf("model %u bytes: steps %d errors %d discards %s wraps %s"
+           " grows %s\n", byteLimit, m->end, m->errors,
+           discards ? "yes" : "no", wraps ? "yes" : "no",
+           grows ? "yes" : "no");
+    undo_free(&us);
+    free(m);
+}
+
+int main(int argc, char** argv)
+{
+    UndoStack us;
+    const UndoValue* st;
+    int i, adv;
+    (void) argc;
+    (void) argv;
+
+    // 1024 bytes holds 256 values, or 25 steps of 10 values.
+    undo_init(&us, 1024);
+    record_steps(&us, 1, 20, 9);
+    print_history(&us, "record 20");
+
+    record_steps(&us, 21, 10, 9);
+    print_history(&us, "record 30");
+
+    for (i = 0; i < 4; ++i)
+        adv = undo_stepBack(&us, &st);
+    printf("back 4: step %d adv %d\n", st->op.code, adv);
+    print_history(&us, "after back");
+
+    // Recording drops the redo steps.
+    record_steps(&us, 31, 2, 30);
+    print_history(&us, "record 2");
+
+    while (undo_stepBack(&us, &st) != Undo_AtEnd)
+        ;
+    adv = undo_stepForward(&us, &st);
+    printf("first step %d adv %d\n", st->op.code, adv);
+
+    undo_clear(&us);
+    print_history(&us, "clear");
+    undo_free(&us);
+
+    model_test(256, MODEL_VALUES, 20000);
+    model_test(1024, MODEL_VALUES, 20000);
+    model_test(20000, MODEL_VALUES, 20000);
+    model_test(256, 250, 5000);         // Steps larger than the limit.
+    return 0;
+}